@@ -0,0 +1,135 @@
+#include "experiments/marching_cubes.h"
+#include "experiments/sdf_function.h"
+#include "experiments/shadertoy.h"
+#include "experiments/sphere_tracing.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// Macrobenchmarks of whole drawImage and march runs, including writing the file.
+// Both run on all hardware threads, so wall time is reported. BM_MarchCubeKernel measures one stage of march.
+
+namespace {
+// march and drawImage log progress to std::cout, it is muted while they are measured
+class MuteCout {
+public:
+    MuteCout() { prev = std::cout.rdbuf(&null); }
+    ~MuteCout() { std::cout.rdbuf(prev); }
+
+private:
+    struct NullBuf : std::streambuf {
+        int overflow(int c) override { return c; }
+    } null;
+    std::streambuf* prev;
+};
+
+void BM_DrawImage(benchmark::State& state)
+{
+    const int size = state.range(0);
+    const vec2 resolution(size, size);
+    MuteCout mute;
+    for (auto _ : state) {
+        drawImage(size, size, "bench_image.bmp", [&](const vec2& fragCoord) -> vec4 {
+            vec2 uv = fragCoord / resolution;
+            vec3 col = 0.5 + 0.5 * cos(iTime + uv.xyx + vec3(0, 2, 4));
+            return vec4(col, 1);
+        });
+    }
+    std::remove("bench_image.bmp");
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_DrawImage)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Arguments: resolution, MeshExtractor. file_bytes is the size of the PLY written.
+void BM_MarchTorus(benchmark::State& state)
+{
+    const float res = state.range(0);
+    MarchingCubesSettings settings;
+    settings.extractor = MeshExtractor(state.range(1));
+    MuteCout mute;
+    for (auto _ : state)
+        MarchingCubes::march(vec3(res), vec3(-.5), vec3(.5), "bench_torus.ply", map, settings);
+    state.counters["file_bytes"] = double(std::filesystem::file_size("bench_torus.ply"));
+    std::remove("bench_torus.ply");
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_MarchTorus)->ArgsProduct({ { 64, 128, 256 }, { 0, 1, 2 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Arguments: resolution, culling: 0 - none, 1 - sparse (distance), 2 - interval bounds (mapBounds)
+void BM_MarchTorusCulling(benchmark::State& state)
+{
+    const float res = state.range(0);
+    MarchingCubesSettings settings;
+    settings.sparse = state.range(1) == 1;
+    if (state.range(1) == 2)
+        settings.bounds = mapBounds;
+    MuteCout mute;
+    for (auto _ : state)
+        MarchingCubes::march(vec3(res), vec3(-.5), vec3(.5), "bench_torus.ply", map, settings);
+    std::remove("bench_torus.ply");
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_MarchTorusCulling)->ArgsProduct({ { 128, 256 }, { 0, 1, 2 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Polygonization alone, on one thread: the torus is sampled once, then the marching cubes kernel of march()
+// and the one it replaced run on the same samples, without sampling, merging or writing a file.
+// Arguments: resolution, kernel: 0 - reference (a branch per corner, triTable), 1 - current (CaseIndex, compactCases)
+void BM_MarchCubeKernel(benchmark::State& state)
+{
+    const int res = state.range(0);
+    const vec3 bMin(-.5), bMax(.5);
+    std::vector<float> samples(size_t(res + 1) * (res + 1) * (res + 1));
+    for (int x = 0, i = 0; x <= res; ++x)
+        for (int y = 0; y <= res; ++y)
+            for (int z = 0; z <= res; ++z)
+                samples[i++] = map(lerp(bMin, bMax, vec3(x, y, z) / float(res)));
+
+    const bool reference = state.range(1) == 0;
+    size_t triangles = 0;
+    for (auto _ : state)
+        triangles = MarchingCubesDetail::marchSamples(vec3(res), bMin, bMax, samples.data(), reference);
+    state.counters["triangles"] = double(triangles);
+    state.SetItemsProcessed(state.iterations() * res * res * res);
+}
+BENCHMARK(BM_MarchCubeKernel)->ArgsProduct({ { 128, 256 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+
+// same torus as map(), 8 points per call
+floatx8 torusx8(const vec3x8& p)
+{
+    const floatx8 q = sqrt(p.x * p.x + p.y * p.y) - .37f;
+    return sqrt(q * q + p.z * p.z) - .1f;
+}
+
+// Arguments: image size, relaxation * 10, interval bounds (mapBounds) on/off.
+// sdf_per_pixel is counted on an extra single thread render with sdf.
+template <typename SdfFunc>
+void BM_SphereTrace(benchmark::State& state, const SdfFunc& sdf)
+{
+    const int size = state.range(0);
+    SphereTracingSettings settings;
+    settings.relaxation = state.range(1) / 10.f;
+    if (state.range(2))
+        settings.bounds = mapBounds;
+    MuteCout mute;
+    for (auto _ : state)
+        drawSdf(size, size, "bench_sdf.bmp", sdf, Camera(), settings);
+
+    // calls of the benchmarked sdf, packet ones count all 8 lanes as evaluated
+    size_t calls = 0;
+    settings.image.threadCount = 1;
+    if constexpr (std::is_invocable_r_v<floatx8, const SdfFunc&, const vec3x8&>)
+        drawSdf(size, size, "bench_sdf.bmp", [&](const vec3x8& p) { calls += 8; return sdf(p); }, Camera(), settings);
+    else
+        drawSdf(size, size, "bench_sdf.bmp", [&](const vec3& p) { ++calls; return sdf(p); }, Camera(), settings);
+    std::remove("bench_sdf.bmp");
+    state.counters["sdf_per_pixel"] = double(calls) / (size * size);
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+void BM_SphereTraceTorus(benchmark::State& state) { BM_SphereTrace(state, map); }
+void BM_SphereTraceTorusx8(benchmark::State& state) { BM_SphereTrace(state, torusx8); }
+BENCHMARK(BM_SphereTraceTorus)->Args({ 512, 10, 0 })->Args({ 512, 20, 0 })->Args({ 512, 40, 0 })->Args({ 512, 20, 1 })->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SphereTraceTorusx8)->Args({ 512, 10, 0 })->Args({ 512, 20, 0 })->Args({ 512, 40, 0 })->Args({ 512, 20, 1 })->Unit(benchmark::kMillisecond)->UseRealTime();
+}
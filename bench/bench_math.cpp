@@ -0,0 +1,146 @@
+#include "shader_simd.h"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+// Transcendental functions: libm against shader_math.h kernels on floats and packets.
+// Throughput benchmarks report items/s as floats per second, packets are as wide as the
+// enabled instruction set allows (configure with -DCMAKE_CXX_FLAGS=-march=native), portable arrays otherwise.
+// Accuracy benchmarks run once and report max_ulp against double precision libm, simd_mismatches
+// counts lanes of floatx8/floatx16 kernels that differ from float ones. They fail (error_occurred in the output)
+// when max_ulp exceeds the function's bound, or with LIB_MATH_GPU, where packets must match floats bit for bit,
+// on any mismatch. Other modes may mismatch: FMA contraction differs between scalar and vector code,
+// LIB_MATH_FAST packet inversesqrt refines a hardware estimate.
+// sqrt, inversesqrt, mod and step are shader_lib.h functions of the current LIB_CURRENT_MATH in the "fast" rows.
+
+namespace {
+const size_t count = 1024;
+
+std::vector<float> randomFloats(float lo, float hi)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::vector<float> result(count);
+    for (float& f : result)
+        f = dist(rng);
+    return result;
+}
+
+template <typename T, typename F>
+void BM_Throughput(benchmark::State& state, F func, float lo, float hi)
+{
+    const auto a = randomFloats(lo, hi);
+    std::vector<float> out(count);
+    for (auto _ : state) {
+        if constexpr (std::is_same_v<T, float>) {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = func(a[i]);
+        } else {
+            for (size_t i = 0; i < count; i += T::size)
+                func(T::load(&a[i])).store(&out[i]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+// BENCHMARK_CAPTURE needs plain function names
+template <typename F> void BM_Float(benchmark::State& state, F func, float lo, float hi) { BM_Throughput<float>(state, func, lo, hi); }
+template <typename F> void BM_Floatx4(benchmark::State& state, F func, float lo, float hi) { BM_Throughput<floatx4>(state, func, lo, hi); }
+template <typename F> void BM_Floatx8(benchmark::State& state, F func, float lo, float hi) { BM_Throughput<floatx8>(state, func, lo, hi); }
+template <typename F> void BM_Floatx16(benchmark::State& state, F func, float lo, float hi) { BM_Throughput<floatx16>(state, func, lo, hi); }
+
+double ulp(double ref)
+{
+    int e;
+    std::frexp(float(ref), &e);
+    return std::ldexp(1.0, std::max(e - 24, -149));
+}
+
+template <int N, typename F>
+size_t packetMismatches(F func, const float* x, const float* expected)
+{
+    float lanes[N];
+    func(FloatPacket<N>::load(x)).store(lanes);
+    size_t result = 0;
+    for (int i = 0; i < N; ++i)
+        result += memcmp(&lanes[i], &expected[i], sizeof(float)) != 0 && !(std::isnan(lanes[i]) && std::isnan(expected[i]));
+    return result;
+}
+
+// evenly spaced points of [lo, hi], generic func is checked on packets too.
+// Errors are in ulps of the result. With period (mod), results are compared modulo period in ulps of the argument:
+// x - y * floor(x / y) loses the ulps of x when the result is much smaller, and gives y instead of 0
+// when x / y rounds up to an integer.
+template <typename F, typename Ref>
+void BM_Accuracy(benchmark::State& state, F func, Ref ref, float lo, float hi, double maxUlpBound, double period)
+{
+    const size_t points = 1 << 22;
+    double maxUlp = 0.0;
+    size_t mismatches = 0;
+    std::vector<float> x(16), result(16);
+    for (auto _ : state) {
+        for (size_t i = 0; i < points; i += 16) {
+            for (size_t j = 0; j < 16; ++j) {
+                x[j] = lo + (hi - lo) * float(double(i + j) / points);
+                result[j] = func(x[j]);
+                const double expected = ref(double(x[j]));
+                if (std::isfinite(expected) && std::isfinite(result[j]) && period > 0.0) {
+                    const double error = std::abs(result[j] - expected);
+                    maxUlp = std::max(maxUlp, std::min(error, std::abs(period - error)) / ulp(std::max(std::abs(expected), std::abs(double(x[j])))));
+                } else if (std::isfinite(expected) && std::isfinite(result[j])) {
+                    maxUlp = std::max(maxUlp, std::abs(result[j] - expected) / ulp(expected));
+                } else if (float(expected) != result[j] && !(std::isnan(expected) && std::isnan(result[j]))) {
+                    maxUlp = INFINITY;
+                }
+            }
+            if constexpr (std::is_invocable_v<F, floatx8>)
+                mismatches += packetMismatches<8>(func, &x[0], &result[0]) + packetMismatches<8>(func, &x[8], &result[8])
+                    + packetMismatches<16>(func, &x[0], &result[0]);
+        }
+    }
+    state.counters["max_ulp"] = maxUlp;
+    state.counters["simd_mismatches"] = double(mismatches);
+    if (!(maxUlp <= maxUlpBound))
+        state.SkipWithError(("max_ulp " + std::to_string(maxUlp) + " exceeds " + std::to_string(maxUlpBound)).c_str());
+#if LIB_CURRENT_MATH == LIB_MATH_GPU
+    else if (mismatches > 0)
+        state.SkipWithError("packets differ from floats");
+#endif
+}
+
+// clang-format off
+// libmUlp and fastUlp are max_ulp bounds of the two, with or without FMA contraction (sin_large has 6 ulp
+// without FMA), pow error grows with |y log2(x)| as on GPUs (exp2(y * log2(x))). period is 0 except for mod.
+#define MATH_BENCHMARKS(name, libm, kernel, ref, lo, hi, libmUlp, fastUlp, period) \
+    BENCHMARK_CAPTURE(BM_Float, name##_libm, libm, lo, hi);                                   \
+    BENCHMARK_CAPTURE(BM_Float, name##_fast, kernel, lo, hi);                                 \
+    BENCHMARK_CAPTURE(BM_Floatx4, name##_fast, kernel, lo, hi);                               \
+    BENCHMARK_CAPTURE(BM_Floatx8, name##_fast, kernel, lo, hi);                               \
+    BENCHMARK_CAPTURE(BM_Floatx16, name##_fast, kernel, lo, hi);                              \
+    BENCHMARK_CAPTURE(BM_Accuracy, name##_libm, libm, ref, lo, hi, libmUlp, period)->Iterations(1); \
+    BENCHMARK_CAPTURE(BM_Accuracy, name##_fast, kernel, ref, lo, hi, fastUlp, period)->Iterations(1);
+
+MATH_BENCHMARKS(sin, [](float x) { return std::sin(x); }, [](auto x) { return ShaderMath::sin(x); }, [](double x) { return std::sin(x); }, -3.2f, 3.2f, 1, 3, 0.0)
+MATH_BENCHMARKS(sin_large, [](float x) { return std::sin(x); }, [](auto x) { return ShaderMath::sin(x); }, [](double x) { return std::sin(x); }, -1000.f, 1000.f, 1, 8, 0.0)
+MATH_BENCHMARKS(cos, [](float x) { return std::cos(x); }, [](auto x) { return ShaderMath::cos(x); }, [](double x) { return std::cos(x); }, -3.2f, 3.2f, 1, 3, 0.0)
+MATH_BENCHMARKS(exp, [](float x) { return std::exp(x); }, [](auto x) { return ShaderMath::exp(x); }, [](double x) { return std::exp(x); }, -80.f, 80.f, 1, 2, 0.0)
+MATH_BENCHMARKS(exp2, [](float x) { return std::exp2(x); }, [](auto x) { return ShaderMath::exp2(x); }, [](double x) { return std::exp2(x); }, -120.f, 120.f, 1, 2, 0.0)
+MATH_BENCHMARKS(log, [](float x) { return std::log(x); }, [](auto x) { return ShaderMath::log(x); }, [](double x) { return std::log(x); }, 1e-3f, 1e3f, 1, 2, 0.0)
+MATH_BENCHMARKS(log2, [](float x) { return std::log2(x); }, [](auto x) { return ShaderMath::log2(x); }, [](double x) { return std::log2(x); }, 0.5f, 2.f, 1, 3, 0.0)
+MATH_BENCHMARKS(pow, [](float x) { return std::pow(x, 2.5f); }, [](auto x) { return ShaderMath::pow(x, decltype(x)(2.5f)); }, [](double x) { return std::pow(x, 2.5); }, 0.f, 100.f, 1, 24, 0.0)
+MATH_BENCHMARKS(atan, [](float x) { return std::atan(x); }, [](auto x) { return ShaderMath::atan(x); }, [](double x) { return std::atan(x); }, -10.f, 10.f, 1, 3, 0.0)
+MATH_BENCHMARKS(sqrt, [](float x) { return std::sqrt(x); }, [](auto x) { return sqrt(x); }, [](double x) { return std::sqrt(x); }, 0.f, 1e4f, 0.5, 1, 0.0)
+MATH_BENCHMARKS(inversesqrt, [](float x) { return 1.f / std::sqrt(x); }, [](auto x) { return INVERSESQRT(x); }, [](double x) { return 1.0 / std::sqrt(x); }, 1e-4f, 1e4f, 1.5, 2, 0.0)
+MATH_BENCHMARKS(mod, [](float x) { return x - 1.7f * std::floor(x / 1.7f); }, [](auto x) { return mod(x, decltype(x)(1.7f)); },
+    [](double x) { return x - double(1.7f) * std::floor(x / double(1.7f)); }, -100.f, 100.f, 1, 1, double(1.7f))
+MATH_BENCHMARKS(step, [](float x) { return x < 0.5f ? 0.f : 1.f; }, [](auto x) { return step(decltype(x)(0.5f), x); }, [](double x) { return x < 0.5 ? 0.0 : 1.0; }, -1.f, 2.f, 0, 0, 0.0)
+#undef MATH_BENCHMARKS
+// clang-format on
+}
@@ -0,0 +1,193 @@
+#include "shader_dual.h"
+#include "shader_lib.h"
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+// Microbenchmarks of shader_lib primitives. Every iteration runs over an array of inputs,
+// so the compiler can't fold the math away, items/s is operations per second.
+
+namespace {
+const size_t count = 1024;
+
+template <typename V>
+std::vector<V> randomVectors(uint32_t seed, float lo = -1.f, float hi = 1.f)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::vector<V> result(count);
+    for (auto& v : result)
+        for (size_t c = 0; c < sizeof(V) / sizeof(float); ++c)
+            v[c] = dist(rng);
+    return result;
+}
+
+template <typename V>
+void BM_Arithmetic(benchmark::State& state)
+{
+    const auto a = randomVectors<V>(1), b = randomVectors<V>(2), c = randomVectors<V>(3, 1.f, 2.f);
+    std::vector<V> out(count);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = a[i] * b[i] + (a[i] - b[i]) / c[i] * 0.5f;
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_Arithmetic, vec2);
+BENCHMARK_TEMPLATE(BM_Arithmetic, vec3);
+BENCHMARK_TEMPLATE(BM_Arithmetic, vec4);
+
+void BM_SwizzleRead(benchmark::State& state)
+{
+    const auto a = randomVectors<vec4>(1);
+    std::vector<vec3> out(count);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = a[i].zyx + a[i].xxw * vec3(a[i].wzy);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SwizzleRead);
+
+void BM_SwizzleWrite(benchmark::State& state)
+{
+    const auto a = randomVectors<vec4>(1);
+    std::vector<vec4> out = randomVectors<vec4>(2);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i].zy = a[i].xw;
+            out[i].wxz += a[i].yzx;
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SwizzleWrite);
+
+void BM_Normalize(benchmark::State& state)
+{
+    const auto a = randomVectors<vec3>(1, 0.1f, 1.f);
+    std::vector<vec3> out(count);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = normalize(a[i]);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Normalize);
+
+void BM_Smoothstep(benchmark::State& state)
+{
+    const auto a = randomVectors<vec3>(1);
+    std::vector<vec3> out(count);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = smoothstep(vec3(-0.5f), vec3(0.5f), a[i]);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Smoothstep);
+
+void BM_SinCos(benchmark::State& state)
+{
+    const auto a = randomVectors<vec3>(1, -10.f, 10.f);
+    std::vector<vec3> out(count);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = sin(a[i]) + cos(a[i]);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SinCos);
+
+void BM_Mat3MulVec3(benchmark::State& state)
+{
+    const auto a = randomVectors<vec3>(1);
+    const auto rows = randomVectors<vec3>(2);
+    const mat3 m(rows[0], rows[1], rows[2]);
+    std::vector<vec3> out(count);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = m * a[i];
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Mat3MulVec3);
+
+// SDF value and gradient: central differences (7 calls), tetrahedron (5 calls) and one dual3 call
+template <typename T>
+T torus(const Vector3_base<T>& p)
+{
+    const Vector2_base<T> q(length(p.xy) - .37f, p.z);
+    return length(q) - .1f;
+}
+
+void BM_GradientCentral(benchmark::State& state)
+{
+    const auto a = randomVectors<vec3>(1, -.5f, .5f);
+    std::vector<vec4> out(count);
+    const float h = 1e-3f;
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            const vec3 p = a[i];
+            const vec3 g(torus(p + vec3(h, 0, 0)) - torus(p - vec3(h, 0, 0)),
+                torus(p + vec3(0, h, 0)) - torus(p - vec3(0, h, 0)),
+                torus(p + vec3(0, 0, h)) - torus(p - vec3(0, 0, h)));
+            out[i] = vec4(g / (2.f * h), torus(p));
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_GradientCentral);
+
+void BM_GradientTetrahedron(benchmark::State& state)
+{
+    const auto a = randomVectors<vec3>(1, -.5f, .5f);
+    std::vector<vec4> out(count);
+    const float h = 1e-3f;
+    const vec3 k0(1, -1, -1), k1(-1, -1, 1), k2(-1, 1, -1), k3(1, 1, 1);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            const vec3 p = a[i];
+            const vec3 g = k0 * torus(p + k0 * h) + k1 * torus(p + k1 * h) + k2 * torus(p + k2 * h) + k3 * torus(p + k3 * h);
+            out[i] = vec4(g / (4.f * h), torus(p));
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_GradientTetrahedron);
+
+void BM_GradientDual(benchmark::State& state)
+{
+    const auto a = randomVectors<vec3>(1, -.5f, .5f);
+    std::vector<vec4> out(count);
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; ++i) {
+            const dual3 d = torus(dualVariables(a[i]));
+            out[i] = vec4(gradient(d), d.val);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_GradientDual);
+}
@@ -0,0 +1,23 @@
+// Probe TU for cmake/SwizzleCompileBench.cmake: shader style code with swizzlers of every kind.
+// Parts with optional swizzlers are compiled only when they are enabled.
+#include "shader_lib.h"
+
+vec4 probe(const vec2& fragCoord, vec3 ro, vec4 col)
+{
+    vec2 uv = fragCoord.yx * 0.5f;
+    vec3 p = vec3(uv.xy, 1.f) + ro * 0.25f;
+    p.xz += uv;
+#if ENABLE_SWIZZLERS_33
+    p = p.zxy + vec3(ro.yzx);
+#endif
+#if ENABLE_SWIZZLERS_34
+    col += ro.xyzx;
+#endif
+#if ENABLE_SWIZZLERS_43
+    p += col.rgb;
+#endif
+#if ENABLE_SWIZZLERS_44
+    col = col.wzyx * vec4(col.xxyy);
+#endif
+    return col + vec4(p, uv.x);
+}
@@ -0,0 +1,82 @@
+# Writes a SHADER_SWIZZLERS_HEADER (see include/shader_lib.h) declaring only the swizzlers used in SOURCES.
+# cmake -DOUTPUT=<header> -DSOURCES=<file;file...> -P GenerateSwizzlers.cmake
+#
+# Sources are scanned for ".name" where name is 2-4 letters of one of xyzw, rgba, stpq.
+# Matches in comments or of other members (.st, .ba) only add a few unused swizzlers.
+# The header is rewritten only if the list changed, so edits that don't touch swizzlers don't rebuild everything.
+
+set(componentSets xyzw rgba stpq)
+set(patterns "")
+
+foreach(source IN LISTS SOURCES)
+    file(STRINGS "${source}" lines REGEX "\\.[xyzwrgbastpq][xyzwrgbastpq]")
+    foreach(line IN LISTS lines)
+        string(REGEX MATCHALL "\\.[xyzwrgbastpq]+[^A-Za-z0-9_]" tokens "${line} ")
+        foreach(token IN LISTS tokens)
+            string(REGEX REPLACE "[^xyzwrgbastpq]" "" name "${token}")
+            string(LENGTH "${name}" length)
+            if(length LESS 2 OR length GREATER 4)
+                continue()
+            endif()
+
+            # indices of the components, all of them from the same set
+            foreach(componentSet IN LISTS componentSets)
+                set(pattern "")
+                math(EXPR last "${length} - 1")
+                foreach(i RANGE ${last})
+                    string(SUBSTRING "${name}" ${i} 1 c)
+                    string(FIND "${componentSet}" "${c}" index)
+                    if(index EQUAL -1)
+                        set(pattern "")
+                        break()
+                    endif()
+                    string(APPEND pattern "${index}")
+                endforeach()
+                if(pattern)
+                    list(APPEND patterns ${pattern})
+                    break()
+                endif()
+            endforeach()
+        endforeach()
+    endforeach()
+endforeach()
+
+list(REMOVE_DUPLICATES patterns)
+list(SORT patterns)
+
+set(content "// generated by cmake/GenerateSwizzlers.cmake from the swizzlers used in the sources\n\n")
+foreach(size 2 3 4)
+    string(APPEND content "#define SHADER_SWIZZLERS_VEC${size}")
+    foreach(pattern IN LISTS patterns)
+        string(LENGTH "${pattern}" length)
+        string(REGEX MATCH "[${size}-9]" outOfRange "${pattern}")
+        if(outOfRange)
+            continue()
+        endif()
+
+        set(indices "")
+        set(names "")
+        math(EXPR last "${length} - 1")
+        foreach(componentSet IN LISTS componentSets)
+            set(name "")
+            foreach(i RANGE ${last})
+                string(SUBSTRING "${pattern}" ${i} 1 index)
+                string(SUBSTRING "${componentSet}" ${index} 1 c)
+                string(APPEND name "${c}")
+            endforeach()
+            list(APPEND names ${name})
+        endforeach()
+        foreach(i RANGE ${last})
+            string(SUBSTRING "${pattern}" ${i} 1 index)
+            string(APPEND indices ", ${index}")
+        endforeach()
+
+        list(JOIN names ", " names)
+        string(APPEND content " \\\n    Swiz${length}<T, ${size}${indices}> ${names};")
+    endforeach()
+    string(APPEND content "\n")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp" "${content}")
+configure_file("${OUTPUT}.tmp" "${OUTPUT}" COPYONLY)
+file(REMOVE "${OUTPUT}.tmp")
@@ -0,0 +1,29 @@
+# target_used_swizzlers(target)
+# Vector types of the target declare only the swizzlers its sources use, instead of all of them
+# (hundreds of Swiz2/3/4 instantiations per vector type). The list is regenerated when sources change,
+# one list for the whole target, so every TU sees the same vector layout.
+# Only files in the target's SOURCES are scanned: a header with shader code has to be listed there,
+# otherwise its swizzlers fail to compile as missing members.
+
+set(SHADER_SWIZZLERS_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/GenerateSwizzlers.cmake)
+
+function(target_used_swizzlers target)
+    get_target_property(sources ${target} SOURCES)
+    set(scanned "")
+    foreach(source IN LISTS sources)
+        get_filename_component(source "${source}" ABSOLUTE)
+        # the library itself lists all swizzlers
+        if(NOT source MATCHES "/include/(shader_lib\\.h|swizzlers/)" AND EXISTS "${source}")
+            list(APPEND scanned "${source}")
+        endif()
+    endforeach()
+
+    set(header ${CMAKE_CURRENT_BINARY_DIR}/swizzlers/${target}_swizzlers.h)
+    add_custom_command(OUTPUT ${header}
+        COMMAND ${CMAKE_COMMAND} -DOUTPUT=${header} "-DSOURCES=${scanned}" -P ${SHADER_SWIZZLERS_SCRIPT}
+        DEPENDS ${scanned} ${SHADER_SWIZZLERS_SCRIPT}
+        COMMENT "Collecting swizzlers used by ${target}"
+        VERBATIM)
+    target_sources(${target} PRIVATE ${header})
+    target_compile_definitions(${target} PRIVATE SHADER_SWIZZLERS_HEADER="${header}")
+endfunction()
@@ -0,0 +1,73 @@
+# Compile time and object size of a TU including shader_lib.h with all swizzlers,
+# with ENABLE_SWIZZLERS_* switched off, and with only the used ones (GenerateSwizzlers.cmake).
+# cmake -DCOMPILER=<c++> -DINCLUDE_DIR=<include> -DPROBE=<cpp> -DWORK_DIR=<dir> [-DRUNS=5] [-DOUTPUT_JSON=<file>]
+#     -P SwizzleCompileBench.cmake
+# Every configuration is compiled RUNS times, the median time is reported. GCC/Clang style flags.
+
+if(NOT RUNS)
+    set(RUNS 5)
+endif()
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+set(usedHeader "${WORK_DIR}/probe_swizzlers.h")
+execute_process(COMMAND ${CMAKE_COMMAND} -DOUTPUT=${usedHeader} -DSOURCES=${PROBE}
+    -P ${CMAKE_CURRENT_LIST_DIR}/GenerateSwizzlers.cmake)
+
+set(configs all no_44 no_34_44 none used)
+set(flags_all "")
+set(flags_no_44 -DENABLE_SWIZZLERS_44=0)
+set(flags_no_34_44 -DENABLE_SWIZZLERS_34=0 -DENABLE_SWIZZLERS_44=0)
+set(flags_none -DENABLE_SWIZZLERS_33=0 -DENABLE_SWIZZLERS_34=0 -DENABLE_SWIZZLERS_43=0 -DENABLE_SWIZZLERS_44=0)
+set(flags_used "-DSHADER_SWIZZLERS_HEADER=\"${usedHeader}\"")
+
+function(now_us result)
+    string(TIMESTAMP seconds "%s")
+    string(TIMESTAMP fraction "%f")
+    math(EXPR us "${seconds} * 1000000 + ${fraction}")
+    set(${result} ${us} PARENT_SCOPE)
+endfunction()
+
+set(json "{\n  \"compiler\": \"${COMPILER}\",\n  \"runs\": ${RUNS},\n  \"configs\": [")
+message("config        compile ms    object bytes")
+set(first TRUE)
+foreach(config IN LISTS configs)
+    set(object "${WORK_DIR}/probe_${config}.o")
+    set(times "")
+    foreach(run RANGE 1 ${RUNS})
+        now_us(start)
+        execute_process(COMMAND ${COMPILER} -std=c++17 -O2 -I${INCLUDE_DIR} ${flags_${config}} -c ${PROBE} -o ${object}
+            RESULT_VARIABLE failed)
+        now_us(end)
+        if(failed)
+            message(FATAL_ERROR "${config}: probe doesn't compile")
+        endif()
+        math(EXPR ms "(${end} - ${start}) / 1000")
+        # zero padded, so the list sorts numerically
+        string(LENGTH "${ms}" digits)
+        math(EXPR padding "8 - ${digits}")
+        string(REPEAT "0" ${padding} zeros)
+        list(APPEND times "${zeros}${ms}")
+    endforeach()
+
+    list(SORT times)
+    math(EXPR middle "${RUNS} / 2")
+    list(GET times ${middle} median)
+    math(EXPR median "${median}")
+    file(SIZE "${object}" objectSize)
+
+    string(LENGTH "${config}" nameLength)
+    math(EXPR nameLength "14 - ${nameLength}")
+    string(REPEAT " " ${nameLength} nameSpaces)
+    message("${config}${nameSpaces}${median}\t\t${objectSize}")
+
+    if(NOT first)
+        string(APPEND json ",")
+    endif()
+    set(first FALSE)
+    string(APPEND json "\n    { \"name\": \"${config}\", \"compile_ms\": ${median}, \"object_bytes\": ${objectSize} }")
+endforeach()
+string(APPEND json "\n  ]\n}\n")
+
+if(OUTPUT_JSON)
+    file(WRITE "${OUTPUT_JSON}" "${json}")
+endif()
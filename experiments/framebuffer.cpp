@@ -0,0 +1,229 @@
+#include "framebuffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+namespace {
+std::string Extension(const std::string& filename)
+{
+    std::string extension = filename.substr(std::min(filename.size(), filename.find_last_of('.')));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return std::tolower(c); });
+    return extension;
+}
+
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> table;
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void PutBigEndian(uint8_t* dst, uint32_t value)
+{
+    dst[0] = value >> 24;
+    dst[1] = value >> 16;
+    dst[2] = value >> 8;
+    dst[3] = value;
+}
+
+// Writes one PNG chunk whose data comes in pieces: length and type first, crc in finish()
+class PngChunkWriter {
+public:
+    PngChunkWriter(std::ofstream& file, const char* type, uint32_t length)
+        : file(file)
+    {
+        uint8_t header[8];
+        PutBigEndian(header, length);
+        std::copy(type, type + 4, header + 4);
+        file.write(reinterpret_cast<const char*>(header), 8);
+        crc = Crc32(0, header + 4, 4);
+    }
+
+    void write(const uint8_t* data, size_t size)
+    {
+        file.write(reinterpret_cast<const char*>(data), size);
+        crc = Crc32(crc, data, size);
+    }
+
+    void finish()
+    {
+        uint8_t bytes[4];
+        PutBigEndian(bytes, crc);
+        file.write(reinterpret_cast<const char*>(bytes), 4);
+    }
+
+private:
+    std::ofstream& file;
+    uint32_t crc;
+};
+
+// zlib stream of stored deflate blocks: size is known in advance, so it can go in one IDAT chunk
+class StoredDeflateWriter {
+public:
+    static constexpr size_t maxBlock = 65535;
+
+    static uint32_t streamSize(size_t dataSize)
+    {
+        const size_t blocks = std::max<size_t>(1, (dataSize + maxBlock - 1) / maxBlock);
+        return 2 + dataSize + blocks * 5 + 4;
+    }
+
+    StoredDeflateWriter(PngChunkWriter& chunk, size_t dataSize)
+        : chunk(chunk)
+        , remaining(dataSize)
+    {
+        const uint8_t header[2] = { 0x78, 0x01 };
+        chunk.write(header, 2);
+        if (dataSize == 0)
+            beginBlock();
+    }
+
+    void write(const uint8_t* data, size_t size)
+    {
+        while (size > 0) {
+            if (blockLeft == 0)
+                beginBlock();
+            const size_t n = std::min(size, blockLeft);
+            chunk.write(data, n);
+            adler(data, n);
+            data += n;
+            size -= n;
+            blockLeft -= n;
+        }
+    }
+
+    void finish()
+    {
+        uint8_t bytes[4];
+        PutBigEndian(bytes, (adlerB << 16) | adlerA);
+        chunk.write(bytes, 4);
+    }
+
+private:
+    void beginBlock()
+    {
+        blockLeft = std::min(remaining, maxBlock);
+        remaining -= blockLeft;
+        const uint16_t len = blockLeft, nlen = ~len;
+        const uint8_t header[5] = { uint8_t(remaining == 0 ? 1 : 0), uint8_t(len), uint8_t(len >> 8), uint8_t(nlen), uint8_t(nlen >> 8) };
+        chunk.write(header, 5);
+    }
+
+    void adler(const uint8_t* data, size_t size)
+    {
+        // sums fit in 32 bits for 5552 bytes between reductions
+        while (size > 0) {
+            const size_t n = std::min<size_t>(size, 5552);
+            for (size_t i = 0; i < n; ++i) {
+                adlerA += data[i];
+                adlerB += adlerA;
+            }
+            adlerA %= 65521;
+            adlerB %= 65521;
+            data += n;
+            size -= n;
+        }
+    }
+
+    PngChunkWriter& chunk;
+    size_t remaining, blockLeft = 0;
+    uint32_t adlerA = 1, adlerB = 0;
+};
+}
+
+bool Framebuffer::canWrite(const std::string& filename)
+{
+    const std::string extension = Extension(filename);
+    return extension == ".pfm" || extension == ".png";
+}
+
+bool Framebuffer::write(const std::string& filename) const
+{
+    return Extension(filename) == ".png" ? writeToPng(filename) : writeToPfm(filename);
+}
+
+bool Framebuffer::writeToPfm(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+
+    const int outChannels = channels == 1 ? 1 : 3;
+    // negative scale means little endian
+    file << (outChannels == 1 ? "Pf" : "PF") << "\n" << width << " " << height << "\n-1.0\n";
+
+    if (channels == outChannels) {
+        file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+    } else {
+        std::vector<float> rgb(size_t(width) * 3);
+        for (int y = 0; y < height; ++y) {
+            const float* src = row(y);
+            for (int x = 0; x < width; ++x)
+                std::copy(src + size_t(x) * channels, src + size_t(x) * channels + 3, &rgb[size_t(x) * 3]);
+            file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size() * sizeof(float));
+        }
+    }
+
+    file.close();
+    std::cout << "Image written: " << filename << std::endl;
+    return bool(file);
+}
+
+bool Framebuffer::writeToPng(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), 8);
+
+    const uint8_t colorType = channels == 4 ? 6 : channels == 3 ? 2 : 0;
+    uint8_t ihdr[13] = { 0 };
+    PutBigEndian(ihdr, width);
+    PutBigEndian(ihdr + 4, height);
+    ihdr[8] = 8; // bit depth
+    ihdr[9] = colorType;
+    PngChunkWriter header(file, "IHDR", sizeof(ihdr));
+    header.write(ihdr, sizeof(ihdr));
+    header.finish();
+
+    // filter type byte and the row, PNG goes from the top row down
+    const size_t scanlineSize = 1 + size_t(width) * channels;
+    const size_t imageSize = scanlineSize * height;
+    PngChunkWriter idat(file, "IDAT", StoredDeflateWriter::streamSize(imageSize));
+    StoredDeflateWriter deflate(idat, imageSize);
+
+    std::vector<uint8_t> scanline(scanlineSize, 0);
+    for (int y = height - 1; y >= 0; --y) {
+        const float* src = row(y);
+        for (size_t i = 0; i < scanlineSize - 1; ++i)
+            scanline[i + 1] = uint8_t(std::clamp(src[i], 0.f, 1.f) * 255.f + 0.5f);
+        deflate.write(scanline.data(), scanline.size());
+    }
+    deflate.finish();
+    idat.finish();
+
+    PngChunkWriter end(file, "IEND", 0);
+    end.finish();
+
+    file.close();
+    std::cout << "Image written: " << filename << std::endl;
+    return bool(file);
+}
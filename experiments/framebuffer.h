@@ -0,0 +1,43 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Float image for renders that are post-processed: values are not clamped or quantized.
+// Rows go from the bottom up (row y is fragCoord.y == y, same as PFM), channels are interleaved.
+struct Framebuffer {
+    // channels is 1 (gray), 3 (RGB) or 4 (RGBA)
+    Framebuffer(int width, int height, int channels = 4)
+        : width(width)
+        , height(height)
+        , channels(channels)
+        , data(size_t(width) * height * channels, 0.f)
+    {
+    }
+
+    float* row(int y) { return &data[size_t(y) * width * channels]; }
+    const float* row(int y) const { return &data[size_t(y) * width * channels]; }
+    float* pixel(int x, int y) { return row(y) + size_t(x) * channels; }
+    const float* pixel(int x, int y) const { return row(y) + size_t(x) * channels; }
+
+    // true for extensions write() understands: .pfm and .png
+    static bool canWrite(const std::string& filename);
+
+    // format is chosen by extension, returns false if the file can't be written
+    bool write(const std::string& filename) const;
+
+    // Float PFM, little endian. 1 and 3 channel data is written as is in one block,
+    // PFM has no alpha, so RGBA rows are packed to RGB through a row buffer.
+    bool writeToPfm(const std::string& filename) const;
+
+    // 8 bit PNG with stored (uncompressed) deflate blocks, values are clamped to [0, 1].
+    // Scanlines are converted straight from the float rows, no intermediate 8 bit image.
+    bool writeToPng(const std::string& filename) const;
+
+    int width, height, channels;
+    std::vector<float> data;
+};
+
+#endif // FRAMEBUFFER_H
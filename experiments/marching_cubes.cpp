@@ -1,13 +1,26 @@
 #include "marching_cubes.h"
+#include "profiler.h"
+#include "utils.h"
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
 
 namespace {
 
 // http://paulbourke.net/geometry/polygonise/
-int edgeTable[256] = {
+// Crossed edges of every case as bits, used by the reference kernel only
+const int edgeTable[256] = {
     0x0, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
     0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
     0x190, 0x99, 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
@@ -41,7 +54,8 @@ int edgeTable[256] = {
     0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
     0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0
 };
-int triTable[256][16] = {
+// Triangles of every case as triples of edges, -1 terminated
+constexpr int triTable[256][16] = {
     { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
     { 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
     { 0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
@@ -300,159 +314,1055 @@ int triTable[256][16] = {
     { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }
 };
 
-struct GridCell {
-    std::array<vec3, 8> p;
-    std::array<float, 8> val;
+const int cornerOffset[8][3] {
+    { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 },
+    { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 }
 };
 
-struct MarchingTriangle {
-    vec3 p[3];
+// Corners of every edge, ordered from the lower grid point to the upper one,
+// so cells sharing an edge interpolate it in the same direction and get the same vertex
+const int edgeCorners[12][2] {
+    { 0, 1 }, { 1, 2 }, { 3, 2 }, { 0, 3 },
+    { 4, 5 }, { 5, 6 }, { 7, 6 }, { 4, 7 },
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
 };
+const int edgeAxis[12] { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 };
 
-vec3 VertexInterp(float isolevel, vec3 p1, vec3 p2, float val1, float val2)
+// triTable packed into bytes. Case c has triangleCount[c] triangles, their edges are triangleEdges[triangleOffset[c]...],
+// 3 per triangle, and vertexCount[c] distinct edges vertexEdges[vertexOffset[c]...] in the order triangles use them first,
+// so every crossed edge is interpolated once per cell and vertices are created in the same order as by triTable.
+// 5.4 KB with the offsets instead of 16 KB of triTable, mostly -1.
+struct CompactCases {
+    static constexpr int triangleEdgeTotal = 2460, vertexEdgeTotal = 1536;
+
+    uint8_t triangleCount[256];
+    uint8_t vertexCount[256];
+    uint16_t triangleOffset[256];
+    uint16_t vertexOffset[256];
+    uint8_t triangleEdges[triangleEdgeTotal];
+    uint8_t vertexEdges[vertexEdgeTotal];
+};
+
+constexpr CompactCases MakeCompactCases()
+{
+    CompactCases cases {};
+    int triangleEdges = 0, vertexEdges = 0;
+    for (int c = 0; c < 256; ++c) {
+        cases.triangleOffset[c] = triangleEdges;
+        cases.vertexOffset[c] = vertexEdges;
+        bool used[12] {};
+        for (int i = 0; triTable[c][i] != -1; ++i) {
+            const int edge = triTable[c][i];
+            cases.triangleEdges[triangleEdges++] = edge;
+            if (!used[edge]) {
+                used[edge] = true;
+                cases.vertexEdges[vertexEdges++] = edge;
+            }
+        }
+        cases.triangleCount[c] = (triangleEdges - cases.triangleOffset[c]) / 3;
+        cases.vertexCount[c] = vertexEdges - cases.vertexOffset[c];
+    }
+    // wrong totals don't compile: overrunning the arrays isn't a constant expression, a short one fails the static_assert below
+    return triangleEdges == CompactCases::triangleEdgeTotal && vertexEdges == CompactCases::vertexEdgeTotal ? cases : CompactCases {};
+}
+
+constexpr CompactCases compactCases = MakeCompactCases();
+static_assert(compactCases.triangleCount[1] == 1 && compactCases.vertexCount[255] == 0, "compact tables don't match triTable");
+
+// Case of a cell from its 8 corner values, bit i is set when corner i is below isolevel.
+// Two SSE comparisons of 4 corners and their sign bits instead of 8 branches, every x86-64 CPU has SSE2.
+// NaN corners are not below isolevel, as with <.
+int CaseIndex(const float* val, float isolevel)
+{
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    const __m128 t = _mm_set1_ps(isolevel);
+    return _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(val), t)) | _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(val + 4), t)) << 4;
+#else
+    int cubeIndex = 0;
+    for (int i = 0; i < 8; ++i)
+        cubeIndex |= int(val[i] < isolevel) << i;
+    return cubeIndex;
+#endif
+}
+
+// Returns 0 or 1 if the vertex falls on one of the edge ends, -1 if it has to be interpolated
+int SnapToEnd(float isolevel, float val1, float val2)
 {
-    float mu;
     if (std::abs(isolevel - val1) < 0.00001f)
-        return p1;
+        return 0;
     if (std::abs(isolevel - val2) < 0.00001f)
-        return p2;
+        return 1;
     if (std::abs(val1 - val2) < 0.00001f)
-        return p1; // Avoid division by zero if values are same
+        return 0; // Avoid division by zero if values are same
+    return -1;
+}
 
-    mu = (isolevel - val1) / (val2 - val1);
+vec3 VertexInterp(float isolevel, vec3 p1, vec3 p2, float val1, float val2)
+{
+    float mu = (isolevel - val1) / (val2 - val1);
     return p1 + (p2 - p1) * mu;
 }
 
-// Marching Cubes algorithm for a single grid cell
-void MarchCube(std::vector<MarchingTriangle>& triangles, GridCell grid, float isolevel = 0.f)
-{
-    int cubeindex = 0;
-    // Determine the 8-bit cube index
-    if (grid.val[0] < isolevel)
-        cubeindex |= 1;
-    if (grid.val[1] < isolevel)
-        cubeindex |= 2;
-    if (grid.val[2] < isolevel)
-        cubeindex |= 4;
-    if (grid.val[3] < isolevel)
-        cubeindex |= 8;
-    if (grid.val[4] < isolevel)
-        cubeindex |= 16;
-    if (grid.val[5] < isolevel)
-        cubeindex |= 32;
-    if (grid.val[6] < isolevel)
-        cubeindex |= 64;
-    if (grid.val[7] < isolevel)
-        cubeindex |= 128;
-
-    // If the cube is entirely inside or outside the isosurface, no triangles
-    // (This check is implicitly handled by edgeTable[0] and edgeTable[255] being 0)
-    if (edgeTable[cubeindex] == 0) {
-        return;
-    }
+struct BlockMask;
 
-    // Array to store intersection points on the 12 edges
-    vec3 intersectionPoints[12];
-
-    // Calculate intersection points for all intersected edges
-    if (edgeTable[cubeindex] & 0x001)
-        intersectionPoints[0] = VertexInterp(isolevel, grid.p[0], grid.p[1], grid.val[0], grid.val[1]);
-    if (edgeTable[cubeindex] & 0x002)
-        intersectionPoints[1] = VertexInterp(isolevel, grid.p[1], grid.p[2], grid.val[1], grid.val[2]);
-    if (edgeTable[cubeindex] & 0x004)
-        intersectionPoints[2] = VertexInterp(isolevel, grid.p[2], grid.p[3], grid.val[2], grid.val[3]);
-    if (edgeTable[cubeindex] & 0x008)
-        intersectionPoints[3] = VertexInterp(isolevel, grid.p[3], grid.p[0], grid.val[3], grid.val[0]);
-    if (edgeTable[cubeindex] & 0x010)
-        intersectionPoints[4] = VertexInterp(isolevel, grid.p[4], grid.p[5], grid.val[4], grid.val[5]);
-    if (edgeTable[cubeindex] & 0x020)
-        intersectionPoints[5] = VertexInterp(isolevel, grid.p[5], grid.p[6], grid.val[5], grid.val[6]);
-    if (edgeTable[cubeindex] & 0x040)
-        intersectionPoints[6] = VertexInterp(isolevel, grid.p[6], grid.p[7], grid.val[6], grid.val[7]);
-    if (edgeTable[cubeindex] & 0x080)
-        intersectionPoints[7] = VertexInterp(isolevel, grid.p[7], grid.p[4], grid.val[7], grid.val[4]);
-    if (edgeTable[cubeindex] & 0x100)
-        intersectionPoints[8] = VertexInterp(isolevel, grid.p[0], grid.p[4], grid.val[0], grid.val[4]);
-    if (edgeTable[cubeindex] & 0x200)
-        intersectionPoints[9] = VertexInterp(isolevel, grid.p[1], grid.p[5], grid.val[1], grid.val[5]);
-    if (edgeTable[cubeindex] & 0x400)
-        intersectionPoints[10] = VertexInterp(isolevel, grid.p[2], grid.p[6], grid.val[2], grid.val[6]);
-    if (edgeTable[cubeindex] & 0x800)
-        intersectionPoints[11] = VertexInterp(isolevel, grid.p[3], grid.p[7], grid.val[3], grid.val[7]);
-
-    // Build the triangles from the triTable
-    for (int i = 0; triTable[cubeindex][i] != -1; i += 3) {
-        MarchingTriangle t;
-        t.p[0] = intersectionPoints[triTable[cubeindex][i]];
-        t.p[1] = intersectionPoints[triTable[cubeindex][i + 1]];
-        t.p[2] = intersectionPoints[triTable[cubeindex][i + 2]];
-        triangles.push_back(t);
+// Grid points are numbered from 0 to res inclusive on every axis.
+// Samples are stored by x-planes, z is contiguous in a plane.
+struct SampleGrid {
+    SampleGrid(vec3 resolution, vec3 bMin, vec3 bMax)
+        : resolution(resolution)
+        , bMin(bMin)
+        , bMax(bMax)
+        , resX(resolution.x)
+        , resY(resolution.y)
+        , resZ(resolution.z)
+    {
     }
-}
 
-const vec3 gridCellOffset[8] {
-    vec3(0.f, 0.f, 0.f), vec3(1.f, 0.f, 0.f), vec3(1.f, 1.f, 0.f), vec3(0.f, 1.f, 0.f),
-    vec3(0.f, 0.f, 1.f), vec3(1.f, 0.f, 1.f), vec3(1.f, 1.f, 1.f), vec3(0.f, 1.f, 1.f)
+    vec3 point(int x, int y, int z) const { return lerp(bMin, bMax, vec3(x, y, z) / resolution); }
+    size_t planeSize() const { return size_t(resY + 1) * (resZ + 1); }
+    size_t index(int y, int z) const { return size_t(y) * (resZ + 1) + z; }
+
+    // if mask is set, only points of active blocks are sampled, the rest are left as they are
+    void samplePlane(int x, float* plane, const MarchingCubes::BatchFunc& func, const BlockMask* mask) const;
+
+    vec3 resolution, bMin, bMax;
+    int resX, resY, resZ;
 };
 
-struct Model3D {
-    typedef std::array<int, 3> Triangle;
+// Blocks of blockSize^3 cells which may contain the surface of a distance field,
+// or of any field if bounds of it are set
+struct BlockMask {
+    static constexpr int blockSize = 8;
+    typedef std::function<Interval(const Vector3_base<Interval>&)> BoundsFunc;
 
-    Model3D(std::vector<MarchingTriangle> marchingTriangles)
+    BlockMask(const SampleGrid& grid, const MarchingCubes::BatchFunc& func, const BoundsFunc& bounds, int threadCount)
+        : countX((grid.resX + blockSize - 1) / blockSize)
+        , countY((grid.resY + blockSize - 1) / blockSize)
+        , countZ((grid.resZ + blockSize - 1) / blockSize)
+        , active(size_t(countX) * countY * countZ, 0)
     {
-        std::unordered_map<vec3, int> pointHashMap;
-        int indexOffset = 0;
-
-        for (auto& marchTriangle : marchingTriangles) {
-            auto& newTriangle = triangles.emplace_back();
-
-            for (int vi = 0; vi < 3; ++vi) {
-                auto& marchVertex = marchTriangle.p[vi];
-                const auto& foundCell = pointHashMap.find(marchVertex);
-                if (foundCell != pointHashMap.end()) { // if found
-                    newTriangle[vi] = foundCell->second;
-                } else {
-                    pointHashMap.insert({ marchVertex, indexOffset });
-                    newTriangle[vi] = indexOffset;
-                    indexOffset++;
+        PROFILE_SCOPE("cull");
+        struct Block {
+            int x, y, z, size; // in cells
+        };
+
+        int rootSize = blockSize;
+        while (rootSize < std::max({ grid.resX, grid.resY, grid.resZ }))
+            rootSize *= 2;
+
+        const vec3 cellSize = abs(grid.bMax - grid.bMin) / grid.resolution;
+        std::vector<Block> blocks { { 0, 0, 0, rootSize } };
+
+        // grid points of block b are in [lo, hi]
+        const auto blockRange = [&grid](const Block& b, vec3& lo, vec3& hi) {
+            lo = vec3(b.x, b.y, b.z);
+            hi = vec3(std::min(b.x + b.size, grid.resX), std::min(b.y + b.size, grid.resY), std::min(b.z + b.size, grid.resZ));
+        };
+
+        const int chunkSize = 4096;
+        while (!blocks.empty()) {
+            std::vector<char> empty(blocks.size());
+            if (bounds) {
+                // corners are computed as grid points are, so the box contains all of them
+                Utils::parallelFor((blocks.size() + chunkSize - 1) / chunkSize, threadCount, [&](int chunk) {
+                    const size_t end = std::min(size_t(chunk + 1) * chunkSize, blocks.size());
+                    for (size_t i = size_t(chunk) * chunkSize; i < end; ++i) {
+                        vec3 lo, hi;
+                        blockRange(blocks[i], lo, hi);
+                        const vec3 p0 = lerp(grid.bMin, grid.bMax, lo / grid.resolution), p1 = lerp(grid.bMin, grid.bMax, hi / grid.resolution);
+                        empty[i] = bounds(intervalBox(min(p0, p1), max(p0, p1))).excludes(0.f);
+                    }
+                });
+            } else {
+                std::vector<vec3> centers(blocks.size());
+                std::vector<float> halfDiagonals(blocks.size()), distances(blocks.size());
+                for (size_t i = 0; i < blocks.size(); ++i) {
+                    vec3 lo, hi;
+                    blockRange(blocks[i], lo, hi);
+                    centers[i] = lerp(grid.bMin, grid.bMax, (lo + hi) * 0.5f / grid.resolution);
+                    halfDiagonals[i] = length((hi - lo) * cellSize) * 0.5f;
                 }
+
+                Utils::parallelFor((blocks.size() + chunkSize - 1) / chunkSize, threadCount, [&](int chunk) {
+                    const size_t begin = size_t(chunk) * chunkSize;
+                    func(&centers[begin], &distances[begin], std::min<size_t>(chunkSize, blocks.size() - begin));
+                });
+                // small margin for rounding errors in the field and in the diagonal
+                for (size_t i = 0; i < blocks.size(); ++i)
+                    empty[i] = std::abs(distances[i]) > halfDiagonals[i] * 1.001f + 1e-6f;
             }
+
+            std::vector<Block> children;
+            for (size_t i = 0; i < blocks.size(); ++i) {
+                if (empty[i])
+                    continue;
+
+                const Block& b = blocks[i];
+                if (b.size == blockSize) {
+                    active[blockIndex(b.x / blockSize, b.y / blockSize, b.z / blockSize)] = 1;
+                    continue;
+                }
+
+                const int half = b.size / 2;
+                for (int c = 0; c < 8; ++c) {
+                    const Block child { b.x + cornerOffset[c][0] * half, b.y + cornerOffset[c][1] * half, b.z + cornerOffset[c][2] * half, half };
+                    if (child.x < grid.resX && child.y < grid.resY && child.z < grid.resZ)
+                        children.push_back(child);
+                }
+            }
+            blocks.swap(children);
         }
+    }
+
+    size_t blockIndex(int bx, int by, int bz) const { return (size_t(bx) * countY + by) * countZ + bz; }
+    bool isCellActive(int x, int y, int z) const { return active[blockIndex(x / blockSize, y / blockSize, z / blockSize)]; }
 
-        vertices.resize(pointHashMap.size());
-        for (const auto& p : pointHashMap)
-            vertices[p.second] = p.first;
+    // Grid point p is shared by blocks [b0, b1] along an axis
+    static void pointBlocks(int p, int count, int& b0, int& b1)
+    {
+        b0 = p > 0 ? (p - 1) / blockSize : 0;
+        b1 = std::min(p / blockSize, count - 1);
     }
 
-    void writeToObj(const std::string& filename)
+    // For every block along z: whether any block touching the grid point row (x, y, *) is active there
+    void rowActivity(int x, int y, std::vector<char>& rowActive) const
     {
-        std::ofstream outFile(filename);
+        rowActive.assign(countZ, 0);
+        int bx0, bx1, by0, by1;
+        pointBlocks(x, countX, bx0, bx1);
+        pointBlocks(y, countY, by0, by1);
+        for (int bx = bx0; bx <= bx1; ++bx)
+            for (int by = by0; by <= by1; ++by)
+                for (int bz = 0; bz < countZ; ++bz)
+                    rowActive[bz] |= active[blockIndex(bx, by, bz)];
+    }
+
+    size_t activeCount() const { return std::count(active.begin(), active.end(), 1); }
+
+    int countX, countY, countZ;
+    std::vector<char> active;
+};
 
-        outFile << "# Wavefront OBJ file generated by simple_obj_writer.cpp" << std::endl;
-        outFile << "# Vertices: " << vertices.size() << std::endl;
-        outFile << "# Triangles: " << triangles.size() << std::endl;
-        outFile << std::endl;
+void SampleGrid::samplePlane(int x, float* plane, const MarchingCubes::BatchFunc& func, const BlockMask* mask) const
+{
+    PROFILE_SCOPE("sample");
+    std::vector<vec3> row(resZ + 1);
+    std::vector<char> rowActive;
+
+    for (int y = 0; y <= resY; ++y) {
+        for (int z = 0; z <= resZ; ++z)
+            row[z] = point(x, y, z);
 
-        for (const auto& v : vertices) {
-            outFile << "v " << v.x << " " << v.y << " " << v.z << std::endl;
+        if (!mask) {
+            func(row.data(), &plane[index(y, 0)], row.size());
+            continue;
         }
 
-        outFile << std::endl;
-        for (auto t : triangles) {
-            outFile << "f " << t[0] + 1 << " " << t[1] + 1 << " " << t[2] + 1 << std::endl;
+        // sample runs of points needed by active blocks
+        mask->rowActivity(x, y, rowActive);
+        int runBegin = -1;
+        for (int z = 0; z <= resZ + 1; ++z) {
+            bool needed = false;
+            if (z <= resZ) {
+                int bz0, bz1;
+                BlockMask::pointBlocks(z, mask->countZ, bz0, bz1);
+                needed = rowActive[bz0] || rowActive[bz1];
+            }
+
+            if (needed && runBegin == -1) {
+                runBegin = z;
+            } else if (!needed && runBegin != -1) {
+                func(&row[runBegin], &plane[index(y, runBegin)], z - runBegin);
+                runBegin = -1;
+            }
+        }
+    }
+}
+
+// Vertex ids of one x-plane: vertices on the plane's y and z edges,
+// and vertices snapped to a grid point, shared by all edges touching that point. -1 if there is no vertex.
+struct PlaneVertexIds {
+    void reset(size_t planeSize)
+    {
+        yEdges.assign(planeSize, -1);
+        zEdges.assign(planeSize, -1);
+        points.assign(planeSize, -1);
+    }
+
+    std::vector<int> yEdges, zEdges, points;
+};
+
+typedef std::array<int, 3> Triangle;
+typedef std::array<int, 4> Quad; // Surface Nets faces, vertices go around the face like in triangles
+
+enum class MeshFormat { Obj, Ply, Stl };
+
+// format is chosen by extension: .ply and .stl are binary, anything else is OBJ
+MeshFormat MeshFormatFromPath(const std::string& filename)
+{
+    std::string extension = filename.substr(std::min(filename.size(), filename.find_last_of('.')));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return std::tolower(c); });
+
+    if (extension == ".ply")
+        return MeshFormat::Ply;
+    if (extension == ".stl")
+        return MeshFormat::Stl;
+    return MeshFormat::Obj;
+}
+
+constexpr size_t maxObjLineSize = 64; // "v -1.23457e-05 ..." or "f 2147483647 ..." fit
+
+// Text is the same as std::ostream with default precision would produce
+char* FormatObjVertex(char* dst, const vec3& v)
+{
+    *dst++ = 'v';
+    for (int c = 0; c < 3; ++c) {
+        *dst++ = ' ';
+        dst = std::to_chars(dst, dst + maxObjLineSize, v[c], std::chars_format::general, 6).ptr;
+    }
+    *dst++ = '\n';
+    return dst;
+}
+
+template <size_t N>
+char* FormatObjFace(char* dst, const std::array<int, N>& f)
+{
+    *dst++ = 'f';
+    for (size_t c = 0; c < N; ++c) {
+        *dst++ = ' ';
+        dst = std::to_chars(dst, dst + maxObjLineSize, f[c] + 1).ptr;
+    }
+    *dst++ = '\n';
+    return dst;
+}
+
+template <size_t N>
+constexpr size_t plyFaceSize = 1 + sizeof(std::array<int, N>);
+
+template <size_t N>
+void PackPlyFace(char* dst, const std::array<int, N>& f)
+{
+    *dst = N;
+    memcpy(dst + 1, f.data(), sizeof(f));
+}
+
+constexpr size_t stlFaceSize = 50; // normal, 3 vertices, attribute
+
+void PackStlFace(char* dst, const vec3& a, const vec3& b, const vec3& c)
+{
+    const vec3 e1 = b - a;
+    const vec3 e2 = c - a;
+    vec3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+    const float len = length(n);
+    n = len > 0.f ? n / len : vec3(0.f);
+
+    memcpy(dst, &n, sizeof(vec3));
+    memcpy(dst + 1 * sizeof(vec3), &a, sizeof(vec3));
+    memcpy(dst + 2 * sizeof(vec3), &b, sizeof(vec3));
+    memcpy(dst + 3 * sizeof(vec3), &c, sizeof(vec3));
+    memset(dst + 4 * sizeof(vec3), 0, 2);
+}
+
+// STL has only triangles, quads are split along the shorter diagonal
+void PackStlQuad(char* dst, const Quad& q, const std::vector<vec3>& vertices)
+{
+    const vec3 &a = vertices[q[0]], &b = vertices[q[1]], &c = vertices[q[2]], &d = vertices[q[3]];
+    if (dot(c - a, c - a) <= dot(d - b, d - b)) {
+        PackStlFace(dst, a, b, c);
+        PackStlFace(dst + stlFaceSize, a, c, d);
+    } else {
+        PackStlFace(dst, a, b, d);
+        PackStlFace(dst + stlFaceSize, b, c, d);
+    }
+}
+
+// formats count lines with format(index, dst) -> end, chunks of lines are formatted in parallel
+// into separate buffers and written in order
+template <typename FormatFunc>
+void WriteFormatted(std::ofstream& outFile, size_t count, int threadCount, const FormatFunc& format)
+{
+    const size_t linesPerChunk = 1 << 16;
+    const size_t chunkCount = (count + linesPerChunk - 1) / linesPerChunk;
+    threadCount = std::min<size_t>(Utils::resolveThreadCount(threadCount), std::max<size_t>(chunkCount, 1));
+
+    const size_t bufferSize = std::min(count, linesPerChunk) * maxObjLineSize;
+    std::vector<std::unique_ptr<char[]>> buffers(threadCount);
+    for (auto& buffer : buffers)
+        buffer.reset(new char[bufferSize]);
+    std::vector<size_t> sizes(threadCount);
+
+    for (size_t firstChunk = 0; firstChunk < chunkCount; firstChunk += threadCount) {
+        const int chunksInRound = std::min<size_t>(threadCount, chunkCount - firstChunk);
+        Utils::parallelFor(chunksInRound, threadCount, [&](int b) {
+            const size_t begin = (firstChunk + b) * linesPerChunk;
+            const size_t end = std::min(count, begin + linesPerChunk);
+            char* dst = buffers[b].get();
+            for (size_t i = begin; i < end; ++i)
+                dst = format(i, dst);
+            sizes[b] = dst - buffers[b].get();
+        });
+
+        for (int b = 0; b < chunksInRound; ++b)
+            outFile.write(buffers[b].get(), sizes[b]);
+    }
+}
+
+// packs count records of recordSize bytes with pack(index, dst) into a buffer and writes it by large blocks
+template <typename PackFunc>
+void WriteChunked(std::ofstream& outFile, size_t count, size_t recordSize, const PackFunc& pack)
+{
+    const size_t recordsPerChunk = (1 << 20) / recordSize;
+    std::vector<char> buffer(std::min(count, recordsPerChunk) * recordSize);
+
+    for (size_t begin = 0; begin < count; begin += recordsPerChunk) {
+        const size_t end = std::min(count, begin + recordsPerChunk);
+        for (size_t i = begin; i < end; ++i)
+            pack(i, &buffer[(i - begin) * recordSize]);
+        outFile.write(buffer.data(), (end - begin) * recordSize);
+    }
+}
+
+// quadCount is written only for meshes with quads
+void WriteObjHeader(std::ostream& outFile, const std::string& vertexCount, const std::string& triangleCount,
+    const std::string& quadCount = {})
+{
+    outFile << "# Wavefront OBJ file generated by simple_obj_writer.cpp\n";
+    outFile << "# Vertices: " << vertexCount << "\n";
+    outFile << "# Triangles: " << triangleCount << "\n";
+    if (!quadCount.empty())
+        outFile << "# Quads: " << quadCount << "\n";
+    outFile << "\n";
+}
+
+// faceCount is triangles and quads
+void WritePlyHeader(std::ostream& outFile, const std::string& vertexCount, const std::string& faceCount)
+{
+    outFile << "ply\n"
+            << "format binary_little_endian 1.0\n"
+            << "comment generated by ShaderEmul\n"
+            << "element vertex " << vertexCount << "\n"
+            << "property float x\n"
+            << "property float y\n"
+            << "property float z\n"
+            << "element face " << faceCount << "\n"
+            << "property list uchar int vertex_indices\n"
+            << "end_header\n";
+}
+
+void WriteStlHeader(std::ostream& outFile, uint32_t triangleCount)
+{
+    char header[80] = "ShaderEmul binary STL";
+    outFile.write(header, sizeof(header));
+    outFile.write(reinterpret_cast<const char*>(&triangleCount), sizeof(triangleCount));
+}
+
+struct Model3D {
+    void write(const std::string& filename, int threadCount = 1)
+    {
+        PROFILE_SCOPE("write");
+        switch (MeshFormatFromPath(filename)) {
+        case MeshFormat::Ply: writeToPly(filename); break;
+        case MeshFormat::Stl: writeToStl(filename); break;
+        default: writeToObj(filename, threadCount); break;
         }
+    }
+
+    // lines are formatted with std::to_chars into large buffers, chunks of lines in parallel
+    void writeToObj(const std::string& filename, int threadCount = 1)
+    {
+        std::ofstream outFile(filename);
+
+        WriteObjHeader(outFile, std::to_string(vertices.size()), std::to_string(triangles.size()),
+            quads.empty() ? std::string() : std::to_string(quads.size()));
+        WriteFormatted(outFile, vertices.size(), threadCount, [&](size_t i, char* dst) {
+            return FormatObjVertex(dst, vertices[i]);
+        });
+
+        outFile << "\n";
+        WriteFormatted(outFile, triangles.size(), threadCount, [&](size_t i, char* dst) {
+            return FormatObjFace(dst, triangles[i]);
+        });
+        WriteFormatted(outFile, quads.size(), threadCount, [&](size_t i, char* dst) {
+            return FormatObjFace(dst, quads[i]);
+        });
 
         outFile.close();
         std::cout << "Successfully wrote OBJ file: " << filename << std::endl;
     }
 
+    // Binary little endian PLY, vertex array is written as is, faces are packed to 13 bytes (17 for quads)
+    void writeToPly(const std::string& filename)
+    {
+        std::ofstream outFile(filename, std::ios::binary);
+
+        WritePlyHeader(outFile, std::to_string(vertices.size()), std::to_string(triangles.size() + quads.size()));
+
+        static_assert(sizeof(vec3) == 12 && sizeof(Triangle) == 12);
+        outFile.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(vec3));
+        WriteChunked(outFile, triangles.size(), plyFaceSize<3>, [&](size_t i, char* dst) {
+            PackPlyFace(dst, triangles[i]);
+        });
+        WriteChunked(outFile, quads.size(), plyFaceSize<4>, [&](size_t i, char* dst) {
+            PackPlyFace(dst, quads[i]);
+        });
+
+        outFile.close();
+        std::cout << "Successfully wrote PLY file: " << filename << std::endl;
+    }
+
+    // Binary STL, 50 bytes per triangle, quads are 2 triangles
+    void writeToStl(const std::string& filename)
+    {
+        std::ofstream outFile(filename, std::ios::binary);
+
+        WriteStlHeader(outFile, triangles.size() + 2 * quads.size());
+        WriteChunked(outFile, triangles.size(), stlFaceSize, [&](size_t i, char* dst) {
+            const Triangle& t = triangles[i];
+            PackStlFace(dst, vertices[t[0]], vertices[t[1]], vertices[t[2]]);
+        });
+        WriteChunked(outFile, quads.size(), 2 * stlFaceSize, [&](size_t i, char* dst) {
+            PackStlQuad(dst, quads[i], vertices);
+        });
+
+        outFile.close();
+        std::cout << "Successfully wrote STL file: " << filename << std::endl;
+    }
+
     std::vector<vec3> vertices;
     std::vector<Triangle> triangles;
+    std::vector<Quad> quads;
 };
+
+// Writes the mesh chunk by chunk while it is being marched, so only the current chunks are in memory.
+// Counts are not known until the end: the header gets fixed width placeholders, rewritten in finish().
+// OBJ has v and f lines interleaved, PLY needs all vertices before faces,
+// so faces go to a temporary file next to the output and are appended in finish().
+// withQuads has to be known from the start, the OBJ header has one more line then.
+class MeshStreamWriter {
+public:
+    MeshStreamWriter(const std::string& filename, int threadCount, bool withQuads = false)
+        : filename(filename)
+        , format(MeshFormatFromPath(filename))
+        , threadCount(threadCount)
+        , withQuads(withQuads)
+    {
+        file.open(filename, format == MeshFormat::Obj ? std::ios::out : std::ios::out | std::ios::binary);
+        if (format == MeshFormat::Ply)
+            faceFile.open(faceFileName(), std::ios::binary);
+        writeHeader();
+    }
+
+    // New vertices of the chunk get ids from vertexCount() on, chunk faces use these ids.
+    // STL stores positions instead of ids, so it's written from slab: the same faces with local vertices.
+    void append(const Model3D& chunk, const Model3D& slab)
+    {
+        PROFILE_SCOPE("write");
+        switch (format) {
+        case MeshFormat::Obj:
+            WriteFormatted(file, chunk.vertices.size(), threadCount, [&](size_t i, char* dst) {
+                return FormatObjVertex(dst, chunk.vertices[i]);
+            });
+            WriteFormatted(file, chunk.triangles.size(), threadCount, [&](size_t i, char* dst) {
+                return FormatObjFace(dst, chunk.triangles[i]);
+            });
+            WriteFormatted(file, chunk.quads.size(), threadCount, [&](size_t i, char* dst) {
+                return FormatObjFace(dst, chunk.quads[i]);
+            });
+            break;
+        case MeshFormat::Ply:
+            file.write(reinterpret_cast<const char*>(chunk.vertices.data()), chunk.vertices.size() * sizeof(vec3));
+            WriteChunked(faceFile, chunk.triangles.size(), plyFaceSize<3>, [&](size_t i, char* dst) {
+                PackPlyFace(dst, chunk.triangles[i]);
+            });
+            WriteChunked(faceFile, chunk.quads.size(), plyFaceSize<4>, [&](size_t i, char* dst) {
+                PackPlyFace(dst, chunk.quads[i]);
+            });
+            break;
+        case MeshFormat::Stl:
+            WriteChunked(file, slab.triangles.size(), stlFaceSize, [&](size_t i, char* dst) {
+                const Triangle& t = slab.triangles[i];
+                PackStlFace(dst, slab.vertices[t[0]], slab.vertices[t[1]], slab.vertices[t[2]]);
+            });
+            WriteChunked(file, slab.quads.size(), 2 * stlFaceSize, [&](size_t i, char* dst) {
+                PackStlQuad(dst, slab.quads[i], slab.vertices);
+            });
+            break;
+        }
+        vertices += chunk.vertices.size();
+        triangles += chunk.triangles.size();
+        quads += chunk.quads.size();
+    }
+
+    size_t vertexCount() const { return vertices; }
+
+    void finish()
+    {
+        PROFILE_SCOPE("write");
+        if (format == MeshFormat::Ply) {
+            faceFile.close();
+            std::ifstream faces(faceFileName(), std::ios::binary);
+            if (triangles || quads)
+                file << faces.rdbuf();
+            faces.close();
+            std::remove(faceFileName().c_str());
+        }
+
+        file.seekp(0);
+        writeHeader();
+        file.close();
+        std::cout << "Successfully wrote file: " << filename << std::endl;
+    }
+
+private:
+    void writeHeader()
+    {
+        // counts are padded to the same width, so the header size doesn't change when they are rewritten
+        auto padded = [](size_t count) {
+            std::string s = std::to_string(count);
+            s.resize(20, ' ');
+            return s;
+        };
+        switch (format) {
+        case MeshFormat::Obj: WriteObjHeader(file, padded(vertices), padded(triangles), withQuads ? padded(quads) : std::string()); break;
+        case MeshFormat::Ply: WritePlyHeader(file, padded(vertices), padded(triangles + quads)); break;
+        case MeshFormat::Stl: WriteStlHeader(file, triangles + 2 * quads); break;
+        }
+    }
+
+    std::string faceFileName() const { return filename + ".faces.tmp"; }
+
+    const std::string filename;
+    const MeshFormat format;
+    const int threadCount;
+    const bool withQuads;
+    std::ofstream file, faceFile;
+    size_t vertices = 0, triangles = 0, quads = 0;
+};
+
+struct SlabMesh {
+    Model3D mesh;
+    PlaneVertexIds first, last; // vertex ids on the slab border planes
+};
+
+// Marches consecutive x-planes of a slab. Every intersected edge gets a vertex id
+// the first time a triangle uses it, neighbouring cells find it by the edge position in the plane,
+// so vertices are shared without comparing positions.
+class SlabMarcher {
+public:
+    SlabMarcher(const SampleGrid& grid, int xBegin, const BlockMask* mask, float isolevel = 0.f)
+        : grid(grid)
+        , xBegin(xBegin)
+        , mask(mask)
+        , isolevel(isolevel)
+    {
+        planes[0].reset(grid.planeSize());
+        planes[1].reset(grid.planeSize());
+        xEdges.assign(grid.planeSize(), -1);
+    }
+
+    // Polygonizes cells between planes x and x + 1.
+    // referenceKernel selects the per-corner branches and triTable walk MarchCube replaced, for benchmarks.
+    template <bool referenceKernel = false>
+    void marchPlane(int x, const float* plane0, const float* plane1)
+    {
+        PROFILE_SCOPE("march");
+        const float* samples[2] { plane0, plane1 };
+
+        for (int y = 0; y < grid.resY; ++y) {
+            for (int z = 0; z < grid.resZ; ++z) {
+                if (mask && !mask->isCellActive(x, y, z)) {
+                    z += BlockMask::blockSize - 1 - z % BlockMask::blockSize;
+                    continue;
+                }
+
+                float val[8];
+                for (int i = 0; i < 8; ++i) {
+                    const int* offset = cornerOffset[i];
+                    val[i] = samples[offset[0]][grid.index(y + offset[1], z + offset[2])];
+                }
+
+                if constexpr (referenceKernel)
+                    MarchCubeReference(x, y, z, val);
+                else
+                    MarchCube(x, y, z, val);
+            }
+        }
+
+        if (x == xBegin)
+            slab.first = planes[0];
+
+        std::swap(planes[0], planes[1]);
+        planes[1].reset(grid.planeSize());
+        xEdges.assign(grid.planeSize(), -1);
+    }
+
+    SlabMesh finish()
+    {
+        slab.last = std::move(planes[0]);
+        return std::move(slab);
+    }
+
+private:
+    // Marching Cubes algorithm for a single grid cell, val are its corner samples
+    void MarchCube(int x, int y, int z, const float* val)
+    {
+        const int cubeIndex = CaseIndex(val, isolevel);
+        const int triangleCount = compactCases.triangleCount[cubeIndex];
+        if (triangleCount == 0)
+            return;
+
+        // every crossed edge gets its vertex once, then triangles take them by edge
+        int ids[12];
+        const uint8_t* edges = &compactCases.vertexEdges[compactCases.vertexOffset[cubeIndex]];
+        for (int i = 0; i < compactCases.vertexCount[cubeIndex]; ++i)
+            ids[edges[i]] = vertexId(x, y, z, edges[i], val);
+
+        const uint8_t* triangleEdges = &compactCases.triangleEdges[compactCases.triangleOffset[cubeIndex]];
+        std::vector<Triangle>& triangles = slab.mesh.triangles;
+        for (int i = 0; i < triangleCount; ++i, triangleEdges += 3)
+            triangles.push_back({ ids[triangleEdges[0]], ids[triangleEdges[1]], ids[triangleEdges[2]] });
+        PROFILE_COUNT("triangles", triangleCount);
+    }
+
+    // The kernel before CaseIndex and compactCases, same output: a branch per corner,
+    // then every triangle of triTable looks up its 3 vertices, shared edges are looked up again
+    void MarchCubeReference(int x, int y, int z, const float* val)
+    {
+        int cubeindex = 0;
+        if (val[0] < isolevel)
+            cubeindex |= 1;
+        if (val[1] < isolevel)
+            cubeindex |= 2;
+        if (val[2] < isolevel)
+            cubeindex |= 4;
+        if (val[3] < isolevel)
+            cubeindex |= 8;
+        if (val[4] < isolevel)
+            cubeindex |= 16;
+        if (val[5] < isolevel)
+            cubeindex |= 32;
+        if (val[6] < isolevel)
+            cubeindex |= 64;
+        if (val[7] < isolevel)
+            cubeindex |= 128;
+
+        if (edgeTable[cubeindex] == 0)
+            return;
+
+        for (int i = 0; triTable[cubeindex][i] != -1; i += 3) {
+            auto& t = slab.mesh.triangles.emplace_back();
+            t[0] = vertexId(x, y, z, triTable[cubeindex][i], val);
+            t[1] = vertexId(x, y, z, triTable[cubeindex][i + 1], val);
+            t[2] = vertexId(x, y, z, triTable[cubeindex][i + 2], val);
+            PROFILE_COUNT("triangles", 1);
+        }
+    }
+
+    int vertexId(int x, int y, int z, int edge, const float* val)
+    {
+        const int* c1 = cornerOffset[edgeCorners[edge][0]];
+        const int* c2 = cornerOffset[edgeCorners[edge][1]];
+        const float val1 = val[edgeCorners[edge][0]];
+        const float val2 = val[edgeCorners[edge][1]];
+
+        const int snap = SnapToEnd(isolevel, val1, val2);
+        int* id;
+        if (snap != -1) {
+            const int* c = snap ? c2 : c1;
+            id = &planes[c[0]].points[grid.index(y + c[1], z + c[2])];
+        } else {
+            const size_t index = grid.index(y + c1[1], z + c1[2]);
+            switch (edgeAxis[edge]) {
+            case 0: id = &xEdges[index]; break;
+            case 1: id = &planes[c1[0]].yEdges[index]; break;
+            default: id = &planes[c1[0]].zEdges[index]; break;
+            }
+        }
+
+        if (*id == -1) {
+            const vec3 p1 = grid.point(x + c1[0], y + c1[1], z + c1[2]);
+            const vec3 p2 = grid.point(x + c2[0], y + c2[1], z + c2[2]);
+
+            *id = slab.mesh.vertices.size();
+            if (snap == -1)
+                slab.mesh.vertices.push_back(VertexInterp(isolevel, p1, p2, val1, val2));
+            else
+                slab.mesh.vertices.push_back(snap ? p2 : p1);
+            PROFILE_COUNT("vertices", 1);
+        } else {
+            PROFILE_COUNT("vertex_cache_hits", 1);
+        }
+        return *id;
+    }
+
+    const SampleGrid& grid;
+    const int xBegin;
+    const BlockMask* mask; // cells outside active blocks are skipped, their samples are not set
+    const float isolevel;
+
+    SlabMesh slab;
+    PlaneVertexIds planes[2]; // planes x and x + 1 of the current cells
+    std::vector<int> xEdges; // edges between planes x and x + 1
+};
+
+// Gradient of the trilinear interpolation of cell corner values at p in cell coordinates [0, 1]^3
+vec3 TrilinearGradient(const float* val, vec3 p)
+{
+    vec3 gradient(0.f);
+    for (int i = 0; i < 8; ++i) {
+        const int* o = cornerOffset[i];
+        const float wx = o[0] ? p.x : 1.f - p.x, wy = o[1] ? p.y : 1.f - p.y, wz = o[2] ? p.z : 1.f - p.z;
+        gradient += val[i] * vec3((o[0] ? wy : -wy) * wz, wx * (o[1] ? wz : -wz), wx * (o[2] ? wy : -wy));
+    }
+    return gradient;
+}
+
+// Minimizes sum of squared distances to the planes through points with normals, plus regularization
+// times squared distance to massPoint, so the point is defined when the planes are parallel (flat surface)
+// and stays near the crossings. Solved for the offset from massPoint with Cramer's rule.
+vec3 MinimizeQef(const vec3* points, const vec3* normals, int count, vec3 massPoint)
+{
+    const float regularization = 0.05f;
+    float a00 = regularization, a01 = 0.f, a02 = 0.f, a11 = regularization, a12 = 0.f, a22 = regularization;
+    vec3 b(0.f);
+    for (int i = 0; i < count; ++i) {
+        const vec3& n = normals[i];
+        a00 += n.x * n.x, a01 += n.x * n.y, a02 += n.x * n.z;
+        a11 += n.y * n.y, a12 += n.y * n.z, a22 += n.z * n.z;
+        b += n * dot(n, points[i] - massPoint);
+    }
+
+    const float c00 = a11 * a22 - a12 * a12, c01 = a02 * a12 - a01 * a22, c02 = a01 * a12 - a02 * a11;
+    const float det = a00 * c00 + a01 * c01 + a02 * c02;
+    const vec3 offset(
+        c00 * b.x + c01 * b.y + c02 * b.z,
+        c01 * b.x + (a00 * a22 - a02 * a02) * b.y + (a01 * a02 - a00 * a12) * b.z,
+        c02 * b.x + (a01 * a02 - a00 * a12) * b.y + (a00 * a11 - a01 * a01) * b.z);
+    return massPoint + offset / det;
+}
+
+// Surface Nets and dual contouring of consecutive x-planes of a slab. Cells crossing the surface get a vertex
+// when their layer is marched, then every grid edge crossing it on plane x and between planes x and x + 1
+// gets a quad of the 4 cells around it, facing the side below isolevel like marching cubes triangles.
+// Quads on plane x need cells of layer x - 1, so a slab also places vertices of the layer before it:
+// they are slab.first points and AppendSlab links them to the previous slab's last layer, the mesh is
+// the same as if the grid was marched in one slab.
+class SlabNets {
+public:
+    SlabNets(const SampleGrid& grid, int xBegin, const BlockMask* mask, bool dualContouring, float isolevel = 0.f)
+        : grid(grid)
+        , xBegin(xBegin)
+        , mask(mask)
+        , dualContouring(dualContouring)
+        , isolevel(isolevel)
+        , cellSize((grid.bMax - grid.bMin) / grid.resolution)
+    {
+        layers[0].assign(grid.planeSize(), -1);
+        layers[1].assign(grid.planeSize(), -1);
+        slab.first.reset(grid.planeSize());
+        slab.last.reset(grid.planeSize());
+    }
+
+    // Cells of layer xBegin - 1, between planeBefore and plane0. Only for slabs after the first one.
+    void placeLayerBefore(const float* planeBefore, const float* plane0)
+    {
+        placeVertices(xBegin - 1, planeBefore, plane0, layers[0]);
+        slab.first.points = layers[0];
+    }
+
+    // Vertices of cells between planes x and x + 1, quads of edges on plane x and between the planes
+    void marchPlane(int x, const float* plane0, const float* plane1)
+    {
+        PROFILE_SCOPE("march");
+        const std::vector<int>& before = layers[0];
+        const std::vector<int>& cells = layers[1];
+        placeVertices(x, plane0, plane1, layers[1]);
+
+        for (int y = 0; y <= grid.resY; ++y) {
+            for (int z = 0; z <= grid.resZ; ++z) {
+                const bool inside = plane0[grid.index(y, z)] < isolevel;
+                // along y and z on plane x: cells of layers x - 1 and x, -1 on the grid border
+                if (y < grid.resY && z > 0 && z < grid.resZ && inside != (plane0[grid.index(y + 1, z)] < isolevel))
+                    addQuad(inside, before[grid.index(y, z - 1)], before[grid.index(y, z)], cells[grid.index(y, z)], cells[grid.index(y, z - 1)]);
+                if (z < grid.resZ && y > 0 && y < grid.resY && inside != (plane0[grid.index(y, z + 1)] < isolevel))
+                    addQuad(inside, before[grid.index(y - 1, z)], cells[grid.index(y - 1, z)], cells[grid.index(y, z)], before[grid.index(y, z)]);
+                // along x, between the planes
+                if (y > 0 && z > 0 && y < grid.resY && z < grid.resZ && inside != (plane1[grid.index(y, z)] < isolevel))
+                    addQuad(inside, cells[grid.index(y - 1, z - 1)], cells[grid.index(y, z - 1)], cells[grid.index(y, z)], cells[grid.index(y - 1, z)]);
+            }
+        }
+
+        std::swap(layers[0], layers[1]);
+        layers[1].assign(grid.planeSize(), -1);
+    }
+
+    SlabMesh finish()
+    {
+        slab.last.points = std::move(layers[0]);
+        return std::move(slab);
+    }
+
+private:
+    // ids[index(y, z)] is the vertex of cell (x, y, z), cells not crossing the surface stay -1
+    void placeVertices(int x, const float* plane0, const float* plane1, std::vector<int>& ids)
+    {
+        const float* samples[2] { plane0, plane1 };
+        for (int y = 0; y < grid.resY; ++y) {
+            for (int z = 0; z < grid.resZ; ++z) {
+                if (mask && !mask->isCellActive(x, y, z)) {
+                    z += BlockMask::blockSize - 1 - z % BlockMask::blockSize;
+                    continue;
+                }
+
+                float val[8];
+                int inside = 0;
+                for (int i = 0; i < 8; ++i) {
+                    const int* offset = cornerOffset[i];
+                    val[i] = samples[offset[0]][grid.index(y + offset[1], z + offset[2])];
+                    inside += val[i] < isolevel;
+                }
+                if (inside == 0 || inside == 8)
+                    continue;
+
+                ids[grid.index(y, z)] = slab.mesh.vertices.size();
+                slab.mesh.vertices.push_back(cellVertex(x, y, z, val));
+                PROFILE_COUNT("vertices", 1);
+            }
+        }
+    }
+
+    vec3 cellVertex(int x, int y, int z, const float* val) const
+    {
+        // crossings in cell coordinates [0, 1]^3
+        vec3 crossings[12];
+        int count = 0;
+        vec3 massPoint(0.f);
+        for (int e = 0; e < 12; ++e) {
+            const int c1 = edgeCorners[e][0], c2 = edgeCorners[e][1];
+            if ((val[c1] < isolevel) == (val[c2] < isolevel))
+                continue;
+            const vec3 p1(cornerOffset[c1][0], cornerOffset[c1][1], cornerOffset[c1][2]);
+            const vec3 p2(cornerOffset[c2][0], cornerOffset[c2][1], cornerOffset[c2][2]);
+            crossings[count] = VertexInterp(isolevel, p1, p2, val[c1], val[c2]);
+            massPoint += crossings[count++];
+        }
+        massPoint = massPoint / float(count);
+
+        vec3 local = massPoint;
+        if (dualContouring) {
+            // QEF in world units, normals of cells longer along some axis are scaled accordingly
+            vec3 points[12], normals[12];
+            int planes = 0;
+            for (int i = 0; i < count; ++i) {
+                const vec3 gradient = TrilinearGradient(val, crossings[i]) / cellSize;
+                if (dot(gradient, gradient) > 0.f) {
+                    points[planes] = crossings[i] * cellSize;
+                    normals[planes++] = normalize(gradient);
+                }
+            }
+            local = clamp(MinimizeQef(points, normals, planes, massPoint * cellSize) / cellSize, 0.f, 1.f);
+        }
+        return grid.point(x, y, z) + local * cellSize;
+    }
+
+    // a, b, c, d go around the edge counterclockwise seen from its end, the quad is reversed when the end
+    // is below isolevel. Cells missing on the grid border or skipped by the mask are -1, the quad is dropped then.
+    void addQuad(bool startInside, int a, int b, int c, int d)
+    {
+        if (a == -1 || b == -1 || c == -1 || d == -1)
+            return;
+        if (startInside)
+            slab.mesh.quads.push_back({ a, d, c, b });
+        else
+            slab.mesh.quads.push_back({ a, b, c, d });
+        PROFILE_COUNT("quads", 1);
+    }
+
+    const SampleGrid& grid;
+    const int xBegin;
+    const BlockMask* mask; // cells outside active blocks are skipped, their samples are not set
+    const bool dualContouring;
+    const float isolevel;
+    const vec3 cellSize;
+
+    SlabMesh slab;
+    std::vector<int> layers[2]; // vertex ids of cells of layers x - 1 and x, by grid.index(y, z)
+};
+
+// Appends slab to the model. Vertices on the plane shared with the previous slab are taken from
+// the border ids, the rest are numbered in order of the first use, same as if the grid was marched in one slab.
+// On return border holds model ids of the slab's last plane.
+// New vertices get ids from firstId + model.vertices.size(), firstId counts vertices already written when streaming.
+void AppendSlab(Model3D& model, SlabMesh& slab, PlaneVertexIds& border, size_t firstId = 0)
+{
+    PROFILE_SCOPE("merge");
+    std::vector<int> modelIds(slab.mesh.vertices.size(), -1);
+
+    auto linkBorder = [&](const std::vector<int>& slabIds, const std::vector<int>& borderIds) {
+        for (size_t i = 0; i < borderIds.size(); ++i)
+            if (slabIds[i] != -1 && borderIds[i] != -1)
+                modelIds[slabIds[i]] = borderIds[i];
+    };
+    linkBorder(slab.first.yEdges, border.yEdges);
+    linkBorder(slab.first.zEdges, border.zEdges);
+    linkBorder(slab.first.points, border.points);
+
+    for (const auto& t : slab.mesh.triangles) {
+        auto& newTriangle = model.triangles.emplace_back();
+        for (int vi = 0; vi < 3; ++vi) {
+            int& id = modelIds[t[vi]];
+            if (id == -1) {
+                id = firstId + model.vertices.size();
+                model.vertices.push_back(slab.mesh.vertices[t[vi]]);
+            }
+            newTriangle[vi] = id;
+        }
+    }
+    for (const auto& q : slab.mesh.quads) {
+        auto& newQuad = model.quads.emplace_back();
+        for (int vi = 0; vi < 4; ++vi) {
+            int& id = modelIds[q[vi]];
+            if (id == -1) {
+                id = firstId + model.vertices.size();
+                model.vertices.push_back(slab.mesh.vertices[q[vi]]);
+            }
+            newQuad[vi] = id;
+        }
+    }
+
+    auto toModelIds = [&](std::vector<int>& slabIds) {
+        for (int& id : slabIds)
+            if (id != -1)
+                id = modelIds[id];
+    };
+    toModelIds(slab.last.yEdges);
+    toModelIds(slab.last.zEdges);
+    toModelIds(slab.last.points);
+    border = std::move(slab.last);
+}
+
+#ifdef SHADEREMUL_PROFILE
+void WriteProfileReport(const MarchingCubesSettings& settings)
+{
+    if (settings.profileReportPath && Profiler::writeReport(settings.profileReportPath))
+        std::cout << "Profile report: " << settings.profileReportPath << std::endl;
+}
+#else
+inline void WriteProfileReport(const MarchingCubesSettings&) {}
+#endif
+}
+
+void MarchingCubes::march(vec3 resolution, vec3 bMin, vec3 bMax,
+    const char* filePath, std::function<float(vec3)> func, const MarchingCubesSettings& settings)
+{
+    march(resolution, bMin, bMax, filePath, [&func](const vec3* in, float* out, size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = func(in[i]);
+    }, settings);
 }
 
 void MarchingCubes::march(vec3 resolution, vec3 bMin, vec3 bMax,
-    const char* filePath, std::function<float(vec3)> func)
+    const char* filePath, BatchFunc func, const MarchingCubesSettings& settings)
 {
     using namespace std::chrono;
     auto timestampStart = high_resolution_clock::now();
@@ -464,40 +1374,143 @@ void MarchingCubes::march(vec3 resolution, vec3 bMin, vec3 bMax,
         timestampStart = high_resolution_clock::now();
     };
 
-    std::vector<MarchingTriangle> triangles;
-    std::unordered_map<vec3, float> cachedValues;
+    // flushes denormals with LIB_MATH_GPU, parallelFor threads inherit it
+    const ShaderMath::FloatEnvironmentScope floatEnvironment;
 
-    std::cout << "Marching progress:";
-    for (int x = 0; x < resolution.x; ++x) {
-        std::cout << '|';
-        for (int y = 0; y < resolution.y; ++y) {
-            for (int z = 0; z < resolution.z; ++z) {
+    // Grid is split along x in slabs, every slab has its own mesh,
+    // so threads don't share anything. A few slabs per thread even out the load,
+    // as slabs crossing the surface are much slower than empty ones.
+    // Slab meshes are appended in x order, so the result doesn't depend on thread count.
+    const SampleGrid grid(resolution, bMin, bMax);
+    const int threadCount = Utils::resolveThreadCount(settings.threadCount);
+    const int slabCount = std::max(1, std::min(grid.resX, threadCount > 1 ? threadCount * 4 : 1));
+    const size_t planeSize = grid.planeSize();
 
-                GridCell gridCell;
-                for (int i = 0; i < 8; ++i) {
-                    const vec3 fraction = (vec3(x, y, z) + gridCellOffset[i]) / resolution;
-                    gridCell.p[i] = lerp(bMin, bMax, fraction);
-
-                    auto it = cachedValues.find(gridCell.p[i]);
-                    if (it == cachedValues.end()) {
-                        gridCell.val[i] = func(gridCell.p[i]);
-                        cachedValues[gridCell.p[i]] = gridCell.val[i];
-                    } else {
-                        gridCell.val[i] = it->second;
-                    }
+#ifdef SHADEREMUL_PROFILE
+    Profiler::reset();
+    func = [inner = std::move(func)](const vec3* in, float* out, size_t n) {
+        PROFILE_SCOPE("sdf");
+        PROFILE_COUNT("sdf_calls", n);
+        inner(in, out, n);
+    };
+#endif
+
+    std::unique_ptr<BlockMask> mask;
+    if (settings.sparse || settings.bounds) {
+        mask = std::make_unique<BlockMask>(grid, func, settings.bounds, threadCount);
+        std::cout << "Active blocks: " << mask->activeCount() << " of " << mask->active.size() << std::endl;
+        logTimer("Culling time: ");
+    }
+
+    std::vector<float> field;
+    if (!settings.lowMemory && !settings.streaming) {
+        field.resize((grid.resX + 1) * planeSize);
+        Utils::parallelFor(grid.resX + 1, threadCount, [&](int x) {
+            grid.samplePlane(x, &field[x * planeSize], func, mask.get());
+        });
+        logTimer("Sampling time: ");
+    }
+
+    // marches planes [xBegin, xEnd) from the dense field or from two planes sampled on the fly.
+    // Surface Nets also need cells before xBegin, without the dense field plane xBegin - 1 is sampled for them.
+    auto marchPlanes = [&](auto marcher, int xBegin, int xEnd) {
+        constexpr bool nets = std::is_same_v<decltype(marcher), SlabNets>;
+        if (!field.empty()) {
+            if constexpr (nets)
+                if (xBegin > 0)
+                    marcher.placeLayerBefore(&field[(xBegin - 1) * planeSize], &field[xBegin * planeSize]);
+            for (int x = xBegin; x < xEnd; ++x) {
+                std::cout << '|';
+                marcher.marchPlane(x, &field[x * planeSize], &field[(x + 1) * planeSize]);
+            }
+        } else {
+            std::vector<float> plane0(planeSize), plane1(planeSize);
+            grid.samplePlane(xBegin, plane0.data(), func, mask.get());
+            if constexpr (nets) {
+                if (xBegin > 0) {
+                    grid.samplePlane(xBegin - 1, plane1.data(), func, mask.get());
+                    marcher.placeLayerBefore(plane1.data(), plane0.data());
                 }
+            }
+            for (int x = xBegin; x < xEnd; ++x) {
+                std::cout << '|';
+                grid.samplePlane(x + 1, plane1.data(), func, mask.get());
+                marcher.marchPlane(x, plane0.data(), plane1.data());
+                plane0.swap(plane1);
+            }
+        }
+        return marcher.finish();
+    };
+    auto marchSlab = [&](int xBegin, int xEnd) {
+        if (settings.extractor == MeshExtractor::MarchingCubes)
+            return marchPlanes(SlabMarcher(grid, xBegin, mask.get()), xBegin, xEnd);
+        return marchPlanes(SlabNets(grid, xBegin, mask.get(), settings.extractor == MeshExtractor::DualContouring), xBegin, xEnd);
+    };
+
+    if (settings.streaming) {
+        // thin slabs are marched threadCount at a time, merged and written in x order, then dropped
+        const int slabPlanes = 16;
+        const int streamSlabCount = (grid.resX + slabPlanes - 1) / slabPlanes;
+        std::vector<SlabMesh> slabs(threadCount);
+        MeshStreamWriter writer(filePath, threadCount, settings.extractor != MeshExtractor::MarchingCubes);
+        PlaneVertexIds border;
 
-                MarchCube(triangles, gridCell);
+        std::cout << "Marching progress:";
+        for (int firstSlab = 0; firstSlab < streamSlabCount; firstSlab += threadCount) {
+            const int slabsInRound = std::min(threadCount, streamSlabCount - firstSlab);
+            Utils::parallelFor(slabsInRound, threadCount, [&](int i) {
+                const int xBegin = (firstSlab + i) * slabPlanes;
+                slabs[i] = marchSlab(xBegin, std::min(grid.resX, xBegin + slabPlanes));
+            });
+
+            for (int i = 0; i < slabsInRound; ++i) {
+                Model3D chunk;
+                AppendSlab(chunk, slabs[i], border, writer.vertexCount());
+                writer.append(chunk, slabs[i].mesh);
+                slabs[i] = SlabMesh();
             }
         }
+        std::cout << std::endl;
+
+        writer.finish();
+        logTimer("Marching and write to file time: ");
+        WriteProfileReport(settings);
+        return;
     }
 
+    std::vector<SlabMesh> slabs(slabCount);
+
+    std::cout << "Marching progress:";
+    Utils::parallelFor(slabCount, threadCount, [&](int slab) {
+        slabs[slab] = marchSlab(grid.resX * slab / slabCount, grid.resX * (slab + 1) / slabCount);
+    });
+
     std::cout << std::endl;
     logTimer("Marching cubes generation time: ");
 
-    Model3D model(triangles);
-    logTimer("Remove vertex duplicates time: ");
+    Model3D model;
+    PlaneVertexIds border;
+    for (auto& slab : slabs) {
+        AppendSlab(model, slab, border);
+        slab = SlabMesh();
+    }
+    logTimer("Merge slabs time: ");
 
-    model.writeToObj(filePath);
+    model.write(filePath, threadCount);
     logTimer("Write to file time: ");
+    WriteProfileReport(settings);
+}
+
+size_t MarchingCubesDetail::marchSamples(vec3 resolution, vec3 bMin, vec3 bMax, const float* samples, bool referenceKernel)
+{
+    const SampleGrid grid(resolution, bMin, bMax);
+    const size_t planeSize = grid.planeSize();
+    SlabMarcher marcher(grid, 0, nullptr);
+    for (int x = 0; x < grid.resX; ++x) {
+        if (referenceKernel)
+            marcher.marchPlane<true>(x, &samples[x * planeSize], &samples[(x + 1) * planeSize]);
+        else
+            marcher.marchPlane(x, &samples[x * planeSize], &samples[(x + 1) * planeSize]);
+    }
+    return marcher.finish().mesh.triangles.size();
 }
@@ -1,12 +1,87 @@
 #ifndef MARCHING_CUBES_H
 #define MARCHING_CUBES_H
 
+#include "shader_interval.h"
 #include "shader_lib.h"
 #include <functional>
+#include <type_traits>
+
+// How the mesh is built from the sampled field
+enum class MeshExtractor {
+    // Paul Bourke's tables, up to 5 triangles per cell, vertices on the grid edges
+    MarchingCubes,
+    // One vertex per cell crossing the surface, at the average of the crossings on its edges,
+    // and a quad per grid edge crossing it, between the 4 cells around the edge. OBJ and PLY store quads
+    // as 4-vertex faces, half the face records of marching cubes, STL splits them into 2 triangles.
+    // No slivers, the surface is smoothed a little.
+    SurfaceNets,
+    // Surface Nets with cell vertices at the QEF minimizer of the crossings and their normals
+    // (gradients of the trilinear interpolation of the samples), sharp edges and corners are kept
+    DualContouring,
+};
+
+struct MarchingCubesSettings {
+    int threadCount = 0; // 0 - all hardware threads, 1 - march on the caller thread
+
+    // func is sampled once per grid point into a dense (res + 1)^3 float field before polygonization.
+    // In low memory mode every slab keeps only two x-planes of samples instead,
+    // planes on slab borders are sampled twice.
+    bool lowMemory = false;
+
+    // Coarse-to-fine culling: func is evaluated at centers of blocks, halving ones that can contain the surface,
+    // down to 8^3 cells. Blocks with |func(center)| > half diagonal are skipped, their points are not sampled.
+    // Only valid if func is a distance field or a lower bound of it (|gradient| <= 1), holes appear otherwise.
+    bool sparse = false;
+
+    // Interval bounds of func over a box (see shader_interval.h), such as func templated on its scalar type
+    // called with Vector3_base<Interval>. If set, blocks are culled as above but skipped when the bounds exclude 0,
+    // which is valid for any func, not only distance fields, and needs no func calls.
+    std::function<Interval(const Vector3_base<Interval>&)> bounds;
+
+    // Out-of-core mode: the grid is marched in thin x-slabs, a few at a time, samples are kept as in low memory mode,
+    // and every finished slab's vertices and faces are written to the file right away.
+    // Memory is bounded by the slab size instead of the mesh size. OBJ output has v and f lines interleaved.
+    bool streaming = false;
+
+    // All extractors work in every mode above and use the same samples
+    MeshExtractor extractor = MeshExtractor::MarchingCubes;
+
+    // Stage timers (sdf, sample, cull, march, merge, write) and counters (sdf calls, vertex cache hits,
+    // vertices, triangles) per thread are written here as JSON. Only when built with SHADEREMUL_PROFILE.
+    const char* profileReportPath = nullptr;
+};
 
 class MarchingCubes {
 public:
-    static void march(vec3 resolution, vec3 bMin, vec3 bMax, const char* filePath, std::function<float(vec3)> func);
+    // Evaluates n points at once: out[i] = f(in[i]). The grid is sampled by rows of (res.z + 1) points.
+    typedef std::function<void(const vec3* in, float* out, size_t n)> BatchFunc;
+
+    // func is called from several threads at once when threadCount != 1
+    static void march(vec3 resolution, vec3 bMin, vec3 bMax, const char* filePath, BatchFunc func,
+        const MarchingCubesSettings& settings = {});
+
+    // same as above, func is called for every point
+    static void march(vec3 resolution, vec3 bMin, vec3 bMax, const char* filePath, std::function<float(vec3)> func,
+        const MarchingCubesSettings& settings = {});
+
+    // func is a lambda or function with float(vec3) signature, it is inlined into the loop over a row of samples,
+    // so there is one indirect call per row instead of one per point
+    template <typename SdfFunc, typename = std::enable_if_t<std::is_invocable_r_v<float, const SdfFunc&, vec3>>>
+    static void march(vec3 resolution, vec3 bMin, vec3 bMax, const char* filePath, const SdfFunc& func,
+        const MarchingCubesSettings& settings = {})
+    {
+        march(resolution, bMin, bMax, filePath, BatchFunc([&func](const vec3* in, float* out, size_t n) {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = func(in[i]);
+        }), settings);
+    }
 };
 
+namespace MarchingCubesDetail {
+// Polygonizes a dense field of (res + 1)^3 samples, stored by x-planes with z contiguous, on the caller thread
+// without writing a file, and returns the triangle count. referenceKernel runs the per-cell kernel march() used
+// before the compact case tables instead of the current one, so benchmarks can compare them on the same samples.
+size_t marchSamples(vec3 resolution, vec3 bMin, vec3 bMax, const float* samples, bool referenceKernel = false);
+}
+
 #endif // MARCHING_CUBES_H
@@ -0,0 +1,112 @@
+#include "profiler.h"
+
+#ifdef SHADEREMUL_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+
+namespace Profiler {
+namespace {
+    struct Slot {
+        const char* name;
+        bool isTimer;
+    };
+
+    std::mutex slotMutex;
+    Slot slots[maxSlots];
+    int slotCount = 0;
+
+    // Workers of a parallelFor never run at the same time as the previous workers with the same index,
+    // so stats are plain sums without atomics. Indices past maxThreads share the last entry.
+    ThreadStats stats[maxThreads];
+    std::atomic<int> threadsUsed { 1 };
+    thread_local int threadIndex = 0;
+
+    // per thread values of a slot, timers in milliseconds
+    void writeThreadValues(std::ostream& os, int slot, bool isTimer)
+    {
+        os << "[";
+        for (int t = 0; t < threadsUsed; ++t) {
+            os << (t ? ", " : "");
+            if (isTimer)
+                os << stats[t].value[slot] * 1e-6;
+            else
+                os << stats[t].value[slot];
+        }
+        os << "]";
+    }
+}
+
+int registerName(const char* name, bool isTimer)
+{
+    std::lock_guard<std::mutex> lock(slotMutex);
+    for (int i = 0; i < slotCount; ++i)
+        if (strcmp(slots[i].name, name) == 0)
+            return i;
+
+    // too many names: the rest are summed into the last slot
+    if (slotCount == maxSlots)
+        return maxSlots - 1;
+    slots[slotCount] = { name, isTimer };
+    return slotCount++;
+}
+
+ThreadStats& threadStats() { return stats[threadIndex]; }
+
+void setThreadIndex(int index)
+{
+    threadIndex = std::min(index, maxThreads - 1);
+    int used = threadsUsed;
+    while (used <= threadIndex && !threadsUsed.compare_exchange_weak(used, threadIndex + 1)) { }
+}
+
+void reset()
+{
+    memset(stats, 0, sizeof(stats));
+    threadsUsed = 1;
+}
+
+void writeReport(std::ostream& os)
+{
+    std::lock_guard<std::mutex> lock(slotMutex);
+    os << "{\n  \"threads\": " << threadsUsed << ",\n";
+    for (int isTimer = 1; isTimer >= 0; --isTimer) {
+        os << (isTimer ? "  \"timers\": {" : "  \"counters\": {");
+        bool first = true;
+        for (int i = 0; i < slotCount; ++i) {
+            if (slots[i].isTimer != bool(isTimer))
+                continue;
+
+            uint64_t value = 0, calls = 0;
+            for (int t = 0; t < threadsUsed; ++t) {
+                value += stats[t].value[i];
+                calls += stats[t].calls[i];
+            }
+
+            os << (first ? "\n" : ",\n") << "    \"" << slots[i].name << "\": { ";
+            if (isTimer)
+                os << "\"ms\": " << value * 1e-6 << ", \"calls\": " << calls << ", \"thread_ms\": ";
+            else
+                os << "\"total\": " << value << ", \"calls\": " << calls << ", \"thread_total\": ";
+            writeThreadValues(os, i, isTimer);
+            os << " }";
+            first = false;
+        }
+        os << (first ? "}" : "\n  }") << (isTimer ? ",\n" : "\n");
+    }
+    os << "}\n";
+}
+
+bool writeReport(const char* path)
+{
+    std::ofstream file(path);
+    writeReport(file);
+    return bool(file);
+}
+}
+
+#endif // SHADEREMUL_PROFILE
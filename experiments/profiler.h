@@ -0,0 +1,83 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Hot path instrumentation: scoped timers and counters, summed per worker thread
+// and written as a JSON report. Enabled by defining SHADEREMUL_PROFILE
+// (cmake -DSHADEREMUL_PROFILE=ON), otherwise the macros expand to nothing.
+//
+//  PROFILE_SCOPE("sdf");             time until the end of the scope is added to timer "sdf"
+//  PROFILE_COUNT("triangles", n);    n is added to counter "triangles"
+//  PROFILE_THREAD(index);            following stats of this thread go to worker index
+
+#ifdef SHADEREMUL_PROFILE
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+namespace Profiler {
+const int maxSlots = 64;
+const int maxThreads = 256;
+
+struct ThreadStats {
+    uint64_t value[maxSlots]; // nanoseconds for timers, sum for counters
+    uint64_t calls[maxSlots];
+};
+
+// Returns the slot of name, same names share a slot. Called once per call site.
+int registerName(const char* name, bool isTimer);
+
+ThreadStats& threadStats();
+void setThreadIndex(int index);
+
+void reset();
+void writeReport(std::ostream& os);
+bool writeReport(const char* path);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(int slot)
+        : slot(slot)
+        , start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        ThreadStats& stats = threadStats();
+        stats.value[slot] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        stats.calls[slot]++;
+    }
+
+private:
+    const int slot;
+    const std::chrono::steady_clock::time_point start;
+};
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#define PROFILE_SCOPE(name)                                                                              \
+    static const int PROFILE_CONCAT(profileSlot, __LINE__) = Profiler::registerName(name, true); \
+    Profiler::ScopedTimer PROFILE_CONCAT(profileTimer, __LINE__)(PROFILE_CONCAT(profileSlot, __LINE__))
+
+#define PROFILE_COUNT(name, n)                                               \
+    do {                                                                     \
+        static const int profileSlot = Profiler::registerName(name, false); \
+        Profiler::ThreadStats& profileStats = Profiler::threadStats();      \
+        profileStats.value[profileSlot] += (n);                              \
+        profileStats.calls[profileSlot]++;                                   \
+    } while (0)
+
+#define PROFILE_THREAD(index) Profiler::setThreadIndex(index)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNT(name, n) ((void)0)
+#define PROFILE_THREAD(index) ((void)0)
+
+#endif // SHADEREMUL_PROFILE
+
+#endif // PROFILER_H
@@ -1,9 +1,10 @@
 #include "sdf_function.h"
 
 namespace {
-float sdTorus(vec3 p, vec2 t)
+template <typename T>
+T sdTorus(Vector3_base<T> p, vec2 t)
 {
-    vec2 q = vec2(length(p.xy) - t.x, p.z);
+    Vector2_base<T> q = Vector2_base<T>(length(p.xy) - t.x, p.z);
     return length(q) - t.y;
 }
 }
@@ -12,3 +13,8 @@ float map(const vec3& p)
 {
     return sdTorus(p, vec2(.37, .1));
 }
+
+Interval mapBounds(const Vector3_base<Interval>& p)
+{
+    return sdTorus(p, vec2(.37, .1));
+}
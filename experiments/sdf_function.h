@@ -1,7 +1,11 @@
 #ifndef SDF_FUNCTION_H
 #define SDF_FUNCTION_H
+#include "shader_interval.h"
 #include "shader_lib.h"
 
 float map(const vec3& p);
 
+// bounds of map() over the box p, for MarchingCubesSettings::bounds and SphereTracingSettings::bounds
+Interval mapBounds(const Vector3_base<Interval>& p);
+
 #endif // SDF_FUNCTION_H
@@ -1,8 +1,15 @@
 #ifndef SHADERTOY_H
 #define SHADERTOY_H
+#include "framebuffer.h"
 #include "shader_lib.h"
+#include "shader_simd.h"
 #include "utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
 namespace {
 const float iTime = 0;
 const int width = 256;
@@ -10,26 +17,259 @@ const int height = 256;
 const vec2 iResolution(width, height);
 }
 
-void drawImage(int w, int h, const char* path, std::function<vec4(const vec2&)> shaderFunc)
+struct DrawImageSettings {
+    int threadCount = 0; // 0 - all hardware threads, 1 - render on the caller thread
+    int tileSize = 32; // image is split in tileSize x tileSize tiles, threads take them one by one
+
+    // Adaptive anti-aliasing: after one sample per pixel, pixels whose color differs from a neighbour
+    // by more than aaThreshold in any channel get aaSamples more jittered samples, averaged with the first one.
+    // At most aaBudget * w * h extra samples are taken, the highest contrast pixels are refined first.
+    // With streaming the budget and the ranking are per band (aaBudget * w * band height samples each),
+    // so when the budget limits refinement the image differs from the non-streaming one.
+    int aaSamples = 0; // 0 - one sample per pixel
+    float aaThreshold = 0.1f;
+    float aaBudget = 1.f;
+
+    // Rows are rendered in bands of a few tile rows and written to the file as they finish, bottom band first,
+    // so memory doesn't grow with the image size. The file has its full size from the start,
+    // an interrupted render leaves a valid image with missing rows black.
+    bool streaming = false;
+};
+
+namespace DrawImageDetail {
+// Packet shaders take vec2x8 of a 4x2 pixel block and return vec4x8, lane i is pixel (i % 4, i / 4) of the block
+template <typename ShaderFunc>
+constexpr bool isPacketShader = std::is_invocable_r_v<vec4x8, const ShaderFunc&, const vec2x8&>;
+
+inline void storeLanes(const vec4x8& v, vec4* out)
+{
+    float c[4][8];
+    v.x.store(c[0]), v.y.store(c[1]), v.z.store(c[2]), v.w.store(c[3]);
+    for (int i = 0; i < 8; ++i)
+        out[i] = vec4(c[0][i], c[1][i], c[2][i], c[3][i]);
+}
+
+// Jittered sample offset in [-0.5, 0.5)^2: R2 low discrepancy sequence shifted by a per pixel hash,
+// so it doesn't depend on thread count and neighbour pixels don't share the pattern
+inline vec2 aaOffset(uint32_t pixel, int sample)
 {
-    uint8_t* pixels = new uint8_t[w * h * 3];
-    const vec2 invSize(1.f / w, 1.f / h);
+    uint32_t hash = pixel * 0x9E3779B9u;
+    hash = (hash ^ (hash >> 16)) * 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    const float shiftX = (hash & 0xFFFF) / 65536.f, shiftY = (hash >> 16) / 65536.f;
+
+    const float n = sample + 1;
+    const float x = n * 0.7548776662f + shiftX, y = n * 0.5698402910f + shiftY;
+    return vec2(x - std::floor(x) - 0.5f, y - std::floor(y) - 0.5f);
+}
 
-    for (int y = 0; y < h; ++y) {
+// contrast is measured on displayed colors, HDR values are clamped to [0, 1]
+inline float maxChannelDifference(const vec4& a, const vec4& b)
+{
+    auto diff = [](float a, float b) { return std::abs(std::clamp(a, 0.f, 1.f) - std::clamp(b, 0.f, 1.f)); };
+    return std::max({ diff(a.r, b.r), diff(a.g, b.g), diff(a.b, b.b) });
+}
+
+// Renders pixel rows [rowBegin, rowEnd), counted from the top, same as WriteBMP input,
+// final colors go to store(x, y, color). Unless hdr is set, samples are clamped to [0, 1] before averaging.
+// With adaptive anti-aliasing one more row above and below is sampled to find contrast
+// on the region border, the sample budget is proportional to the region size.
+template <typename ShaderFunc, typename StoreFunc>
+void renderRows(int w, int h, int rowBegin, int rowEnd, const ShaderFunc& shaderFunc, const StoreFunc& store,
+    bool hdr, const DrawImageSettings& settings)
+{
+    const int tileSize = std::max(settings.tileSize, 1);
+    const bool adaptive = settings.aaSamples > 0;
+    const ShaderMath::FloatEnvironmentScope floatEnvironment; // flushes denormals with LIB_MATH_GPU
+    const int sampleBegin = adaptive ? std::max(0, rowBegin - 1) : rowBegin;
+    const int sampleEnd = adaptive ? std::min(h, rowEnd + 1) : rowEnd;
+    const int tilesX = (w + tileSize - 1) / tileSize;
+    const int tilesY = (sampleEnd - sampleBegin + tileSize - 1) / tileSize;
+
+    auto clampSample = [&](const vec4& res) { return hdr ? res : clamp(res, 0, 1); };
+
+    // first sample of every pixel, kept as float colors if they are refined later
+    std::vector<vec4> colors(adaptive ? size_t(w) * (sampleEnd - sampleBegin) : 0);
+    auto color = [&](int x, int y) -> vec4& { return colors[size_t(y - sampleBegin) * w + x]; };
+    auto put = [&](int x, int y, const vec4& res) {
+        if (!adaptive)
+            store(x, y, res);
+        else
+            color(x, y) = clampSample(res);
+    };
+
+    Utils::parallelFor(tilesX * tilesY, settings.threadCount, [&](int tile) {
+        const int x0 = (tile % tilesX) * tileSize, x1 = std::min(x0 + tileSize, w);
+        const int y0 = sampleBegin + (tile / tilesX) * tileSize, y1 = std::min(y0 + tileSize, sampleEnd);
+
+        if constexpr (isPacketShader<ShaderFunc>) {
+            // Blocks are aligned to the image, not to the tile, so lanes of a pixel are the same for any tile size
+            // or band and packet shaders that share work between lanes give the same image.
+            // Lanes out of the tile are shaded but not stored, lanes out of the image repeat its last column or row.
+            for (int y = y0 & ~1; y < y1; y += 2) {
+                for (int x = x0 & ~3; x < x1; x += 4) {
+                    float coordX[8], coordY[8];
+                    for (int i = 0; i < 8; ++i) {
+                        coordX[i] = std::min(x + i % 4, w - 1);
+                        coordY[i] = h - std::min(y + i / 4, h - 1) - 1;
+                    }
+                    vec4 res[8];
+                    storeLanes(shaderFunc(vec2x8(floatx8::load(coordX), floatx8::load(coordY))), res);
+                    for (int i = 0; i < 8; ++i)
+                        if (x + i % 4 >= x0 && x + i % 4 < x1 && y + i / 4 >= y0 && y + i / 4 < y1)
+                            put(x + i % 4, y + i / 4, res[i]);
+                }
+            }
+        } else {
+            for (int y = y0; y < y1; ++y) {
+                for (int x = x0; x < x1; ++x) {
+                    // vec2 coord = vec2(x, y);
+                    vec2 coord = vec2(x, h - y - 1);
+                    put(x, y, shaderFunc(coord));
+                }
+            }
+        }
+    });
+
+    if (!adaptive)
+        return;
+
+    // contrast with 4 neighbours, pixels above the threshold are refined, highest contrast first
+    std::vector<std::pair<float, size_t>> refine;
+    for (int y = rowBegin; y < rowEnd; ++y) {
         for (int x = 0; x < w; ++x) {
-            int index = (y * w + x) * 3;
-            // vec2 coord = vec2(x, y);
-            vec2 coord = vec2(x, h - y - 1);
-            vec4 res = shaderFunc(coord);
-            res = clamp(res * 255, 0, 255);
-            pixels[index + 0] = res.b;
-            pixels[index + 1] = res.g;
-            pixels[index + 2] = res.r;
+            const vec4& c = color(x, y);
+            float contrast = 0.f;
+            if (x > 0)
+                contrast = std::max(contrast, maxChannelDifference(c, color(x - 1, y)));
+            if (x + 1 < w)
+                contrast = std::max(contrast, maxChannelDifference(c, color(x + 1, y)));
+            if (y > 0)
+                contrast = std::max(contrast, maxChannelDifference(c, color(x, y - 1)));
+            if (y + 1 < h)
+                contrast = std::max(contrast, maxChannelDifference(c, color(x, y + 1)));
+            if (contrast > settings.aaThreshold)
+                refine.emplace_back(-contrast, size_t(y) * w + x);
         }
     }
 
-    Utils::WriteBMP(path, w, h, pixels);
-    delete[] pixels;
+    const size_t maxRefined = std::max(0.f, settings.aaBudget) * w * (rowEnd - rowBegin) / settings.aaSamples;
+    if (refine.size() > maxRefined) {
+        std::nth_element(refine.begin(), refine.begin() + maxRefined, refine.end());
+        refine.resize(maxRefined);
+    }
+
+    // refined pixels are still shaded in parallel, chunks of them per task
+    const int chunkSize = 256;
+    Utils::parallelFor((refine.size() + chunkSize - 1) / chunkSize, settings.threadCount, [&](int chunk) {
+        const size_t end = std::min(refine.size(), size_t(chunk + 1) * chunkSize);
+        for (size_t i = size_t(chunk) * chunkSize; i < end; ++i) {
+            const size_t index = refine[i].second;
+            const int x = index % w, y = index / w;
+            const vec2 coord = vec2(x, h - y - 1);
+            vec4 sum = color(x, y);
+            if constexpr (isPacketShader<ShaderFunc>) {
+                // 8 samples of the pixel per call, the last one is repeated in unused lanes
+                for (int s = 0; s < settings.aaSamples; s += 8) {
+                    float coordX[8], coordY[8];
+                    for (int i = 0; i < 8; ++i) {
+                        const vec2 c = coord + aaOffset(index, std::min(s + i, settings.aaSamples - 1));
+                        coordX[i] = c.x, coordY[i] = c.y;
+                    }
+                    vec4 res[8];
+                    storeLanes(shaderFunc(vec2x8(floatx8::load(coordX), floatx8::load(coordY))), res);
+                    for (int i = 0; i < 8 && s + i < settings.aaSamples; ++i)
+                        sum += clampSample(res[i]);
+                }
+            } else {
+                for (int s = 0; s < settings.aaSamples; ++s)
+                    sum += clampSample(shaderFunc(coord + aaOffset(index, s)));
+            }
+            color(x, y) = sum / float(settings.aaSamples + 1);
+        }
+    });
+
+    for (int y = rowBegin; y < rowEnd; ++y)
+        for (int x = 0; x < w; ++x)
+            store(x, y, color(x, y));
+}
+
+// stores colors as BGR bytes of rows from rowBegin, top row first
+inline auto bgrStore(uint8_t* pixels, int w, int rowBegin)
+{
+    return [=](int x, int y, vec4 res) {
+        const size_t index = (size_t(y - rowBegin) * w + x) * 3;
+        res = clamp(res * 255, 0, 255);
+        pixels[index + 0] = res.b;
+        pixels[index + 1] = res.g;
+        pixels[index + 2] = res.r;
+    };
+}
+}
+
+// Renders unclamped float colors into framebuffer, its size is the image size.
+// Row y of the framebuffer is fragCoord.y == y. Streaming doesn't apply, the framebuffer holds the whole image.
+template <typename ShaderFunc>
+void drawImage(Framebuffer& framebuffer, const ShaderFunc& shaderFunc, const DrawImageSettings& settings = {})
+{
+    const int w = framebuffer.width, h = framebuffer.height;
+    DrawImageDetail::renderRows(w, h, 0, h, shaderFunc, [&](int x, int y, const vec4& color) {
+        float* pixel = framebuffer.pixel(x, h - y - 1);
+        for (int c = 0; c < framebuffer.channels; ++c)
+            pixel[c] = color[c];
+    }, true, settings);
+}
+
+// shaderFunc is called from several threads at once, so it should not modify shared state
+// (same as a real fragment shader). Every pixel is computed independently,
+// so the image doesn't depend on thread count or tile size (adaptive samples are also fixed per pixel).
+// ShaderFunc is a lambda or function with vec4(const vec2&) signature, it is inlined into the tile loop.
+// Packet shaders with vec4x8(const vec2x8&) signature shade 4x2 pixel blocks at once (see isPacketShader).
+// Files with .pfm or .png extension are rendered to a float RGB Framebuffer first, anything else is written as BMP.
+// Alpha is dropped like in BMP, render to an RGBA Framebuffer with the overload above to keep it.
+template <typename ShaderFunc>
+void drawImage(int w, int h, const char* path, const ShaderFunc& shaderFunc, const DrawImageSettings& settings = {})
+{
+    if (Framebuffer::canWrite(path)) {
+        Framebuffer framebuffer(w, h, 3);
+        drawImage(framebuffer, shaderFunc, settings);
+        framebuffer.write(path);
+        return;
+    }
+
+    if (!settings.streaming) {
+        uint8_t* pixels = new uint8_t[size_t(w) * h * 3];
+        DrawImageDetail::renderRows(w, h, 0, h, shaderFunc, DrawImageDetail::bgrStore(pixels, w, 0), false, settings);
+        Utils::WriteBMP(path, w, h, pixels);
+        delete[] pixels;
+        return;
+    }
+
+    // Bands of whole tile rows, bottom one first as BMP stores them. A band has enough tiles
+    // to keep threads busy, only one band of pixels is in memory. Band height doesn't depend on thread count,
+    // anti-aliasing budget is per band and the image has to be the same for any threadCount.
+    const int bandTiles = 64;
+    const int tileSize = std::max(settings.tileSize, 1);
+    const int tilesX = (w + tileSize - 1) / tileSize;
+    const int bandHeight = tileSize * std::max(1, (bandTiles + tilesX - 1) / tilesX);
+
+    Utils::BMPWriter writer(path, w, h);
+    if (!writer.isOpen())
+        return;
+
+    std::vector<uint8_t> band(size_t(w) * std::min(bandHeight, h) * 3);
+    for (int rowEnd = h; rowEnd > 0; rowEnd -= bandHeight) {
+        const int rowBegin = std::max(0, rowEnd - bandHeight);
+        DrawImageDetail::renderRows(w, h, rowBegin, rowEnd, shaderFunc, DrawImageDetail::bgrStore(band.data(), w, rowBegin), false, settings);
+        writer.writeRows(band.data(), rowEnd - rowBegin);
+    }
+    writer.close();
+}
+
+inline void drawImage(int w, int h, const char* path, std::function<vec4(const vec2&)> shaderFunc,
+    const DrawImageSettings& settings = {})
+{
+    drawImage<std::function<vec4(const vec2&)>>(w, h, path, shaderFunc, settings);
 }
 
 #endif // SHADERTOY_H
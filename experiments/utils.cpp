@@ -1,10 +1,16 @@
 #include "utils.h"
+#include "profiler.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cfenv>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 namespace Utils {
 #pragma pack(push, 1) // Ensure no padding
@@ -33,15 +39,17 @@ struct BMPInfoHeader {
 
 #pragma pack(pop)
 
-void WriteBMP(const char* filename, int width, int height, const uint8_t* pixelData)
+BMPWriter::BMPWriter(const char* filename, int width, int height)
+    : file(filename, std::ios::binary)
+    , filename(filename)
+    , width(width)
 {
-    std::ofstream file(filename, std::ios::binary);
     if (!file)
         return;
 
-    int rowPadding = (4 - (width * 3) % 4) % 4;
-    int paddedRowSize = width * 3 + rowPadding;
-    int dataSize = paddedRowSize * height;
+    const uint32_t rowPadding = (4 - (width * 3) % 4) % 4;
+    const uint32_t paddedRowSize = width * 3 + rowPadding;
+    const uint32_t dataSize = paddedRowSize * height;
 
     BMPFileHeader fileHeader;
     fileHeader.bfSize = 54 + dataSize;
@@ -54,16 +62,83 @@ void WriteBMP(const char* filename, int width, int height, const uint8_t* pixelD
     file.write(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
     file.write(reinterpret_cast<char*>(&infoHeader), sizeof(infoHeader));
 
+    // extend the file to its full size, rows not written yet read as black
+    if (dataSize > 0) {
+        file.seekp(54 + dataSize - 1);
+        file.put(0);
+        file.seekp(54);
+    }
+    file.flush();
+}
+
+void BMPWriter::writeRows(const uint8_t* pixelData, int rowCount)
+{
+    const int rowPadding = (4 - (width * 3) % 4) % 4;
     uint8_t padding[3] = { 0, 0, 0 };
 
     // BMP stores pixels from bottom to top
-    for (int y = height - 1; y >= 0; --y) {
-        const uint8_t* row = &pixelData[y * width * 3];
+    for (int y = rowCount - 1; y >= 0; --y) {
+        const uint8_t* row = &pixelData[size_t(y) * width * 3];
         file.write(reinterpret_cast<const char*>(row), width * 3);
         file.write(reinterpret_cast<const char*>(padding), rowPadding);
     }
-    std::cout << "Image written: " << filename << std::endl;
+    file.flush();
+}
+
+void BMPWriter::close()
+{
     file.close();
+    std::cout << "Image written: " << filename << std::endl;
+}
+
+void WriteBMP(const char* filename, int width, int height, const uint8_t* pixelData)
+{
+    BMPWriter writer(filename, width, height);
+    if (!writer.isOpen())
+        return;
+
+    writer.writeRows(pixelData, height);
+    writer.close();
+}
+
+int resolveThreadCount(int threadCount)
+{
+    if (threadCount > 0)
+        return threadCount;
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void parallelFor(int count, int threadCount, const std::function<void(int)>& task)
+{
+    threadCount = std::min(resolveThreadCount(threadCount), count);
+    if (threadCount <= 1) {
+        for (int i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    // threads get the caller's rounding and denormal modes, new threads start with defaults
+    std::fenv_t floatEnvironment;
+    std::fegetenv(&floatEnvironment);
+
+    std::atomic<int> nextIndex { 0 };
+    auto worker = [&]() {
+        for (int i = nextIndex++; i < count; i = nextIndex++)
+            task(i);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (int i = 1; i < threadCount; ++i)
+        threads.emplace_back([&worker, &floatEnvironment, i]() {
+            std::fesetenv(&floatEnvironment);
+            PROFILE_THREAD(i);
+            worker();
+        });
+    worker();
+
+    for (auto& t : threads)
+        t.join();
 }
 
 // swizzlers are already done, in "/include/swizzlers" folder
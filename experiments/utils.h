@@ -2,9 +2,41 @@
 #define UTILS_H
 
 #include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
 
 namespace Utils {
+// pixelData is BGR, top row first
 void WriteBMP(const char* filename, int width, int height, const uint8_t* pixelData);
+
+// Writes a BMP by bands of rows, from the bottom of the image to the top, as BMP stores them.
+// The file is created with its full size, so whatever was written before an interruption is a valid image.
+class BMPWriter {
+public:
+    BMPWriter(const char* filename, int width, int height);
+
+    bool isOpen() const { return bool(file); }
+
+    // rowCount rows right above the ones written before, BGR, top row first like WriteBMP.
+    // Rows are flushed to the file before returning.
+    void writeRows(const uint8_t* pixelData, int rowCount);
+    void close();
+
+private:
+    std::ofstream file;
+    std::string filename;
+    int width;
+};
 void makeSwizzlers(uint32_t thisVecSize, uint32_t outVecSize);
+
+// 0 means "all hardware threads"
+int resolveThreadCount(int threadCount);
+
+// Calls task(index) for every index in [0, count) from a pool of threadCount threads.
+// Indices are taken from a shared counter, so a thread that finished its task grabs the next one
+// and slow tasks don't stall the rest. With a single thread everything runs on the caller thread.
+// Threads run with the caller's floating point environment (rounding, flush to zero).
+void parallelFor(int count, int threadCount, const std::function<void(int)>& task);
 }
 #endif // UTILS_H
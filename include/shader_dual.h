@@ -0,0 +1,125 @@
+#ifndef SHADER_DUAL_H
+#define SHADER_DUAL_H
+
+#include "shader_lib.h"
+
+// Forward-mode automatic differentiation. Dual<N> is a float with its N partial derivatives,
+// every operation applies the chain rule, so a function templated on the scalar type
+// (T sdf(const Vector3_base<T>& p)) evaluated on Vector3_base<dual3> returns its value and gradient
+// in one call instead of 4-6 calls of finite differences:
+//
+//   const dual3 d = sdf(dualVariables(p)); // d.val is sdf(p), gradient(d) is its gradient at p
+//
+// Values are computed by the same float functions as for floats, so they match float calls in every LIB_CURRENT_MATH.
+// Comparisons compare values and give bool, branches and ternaries of scalar shader code work unchanged.
+// Derivatives of floor, sign, step and fract jumps are 0, min/max/abs/clamp take the derivative of the selected side.
+
+// clang-format off
+
+template <int N>
+struct Dual {
+    float val;
+    float d[N];
+
+    Dual() = default;
+    // constant, derivatives are 0
+    constexpr FORCEINLINE Dual(float f) : val(f), d{} {}
+
+    // i-th variable, its derivative is 1
+    static FORCEINLINE Dual variable(float f, int i) { Dual r(f); r.d[i] = 1.f; return r; }
+
+    // f(val) with f'(val) = df
+    FORCEINLINE Dual chain(float f, float df) const { Dual r; r.val = f; for (int i = 0; i < N; ++i) r.d[i] = d[i] * df; return r; }
+
+    friend FORCEINLINE Dual operator-(const Dual& a) { return a.chain(-a.val, -1.f); }
+
+    friend FORCEINLINE Dual operator+(const Dual& a, const Dual& b) { Dual r; r.val = a.val + b.val; for (int i = 0; i < N; ++i) r.d[i] = a.d[i] + b.d[i]; return r; }
+    friend FORCEINLINE Dual operator-(const Dual& a, const Dual& b) { Dual r; r.val = a.val - b.val; for (int i = 0; i < N; ++i) r.d[i] = a.d[i] - b.d[i]; return r; }
+    friend FORCEINLINE Dual operator*(const Dual& a, const Dual& b) { Dual r; r.val = a.val * b.val; for (int i = 0; i < N; ++i) r.d[i] = a.d[i] * b.val + a.val * b.d[i]; return r; }
+    friend FORCEINLINE Dual operator/(const Dual& a, const Dual& b) {
+        const float inv = 1.f / b.val; Dual r; r.val = DIV_IMPL(a.val, b.val);
+        for (int i = 0; i < N; ++i) r.d[i] = (a.d[i] - r.val * b.d[i]) * inv;
+        return r; }
+
+    // constant operands skip their zero derivatives
+    friend FORCEINLINE Dual operator+(const Dual& a, float f) { Dual r = a; r.val += f; return r; }
+    friend FORCEINLINE Dual operator+(float f, const Dual& a) { return a + f; }
+    friend FORCEINLINE Dual operator-(const Dual& a, float f) { Dual r = a; r.val -= f; return r; }
+    friend FORCEINLINE Dual operator-(float f, const Dual& a) { return a.chain(f - a.val, -1.f); }
+    friend FORCEINLINE Dual operator*(const Dual& a, float f) { return a.chain(a.val * f, f); }
+    friend FORCEINLINE Dual operator*(float f, const Dual& a) { return a.chain(f * a.val, f); }
+    friend FORCEINLINE Dual operator/(const Dual& a, float f) { return a.chain(DIV_IMPL(a.val, f), 1.f / f); }
+
+    FORCEINLINE Dual& operator+=(const Dual& b) { return *this = *this + b; }
+    FORCEINLINE Dual& operator-=(const Dual& b) { return *this = *this - b; }
+    FORCEINLINE Dual& operator*=(const Dual& b) { return *this = *this * b; }
+    FORCEINLINE Dual& operator/=(const Dual& b) { return *this = *this / b; }
+
+#define SHADER_DUAL_DECLARE_COMPARISON(op) \
+    friend FORCEINLINE bool operator op(const Dual& a, const Dual& b) { return a.val op b.val; }
+    SHADER_DUAL_DECLARE_COMPARISON(<)
+    SHADER_DUAL_DECLARE_COMPARISON(<=)
+    SHADER_DUAL_DECLARE_COMPARISON(>)
+    SHADER_DUAL_DECLARE_COMPARISON(>=)
+    SHADER_DUAL_DECLARE_COMPARISON(==)
+    SHADER_DUAL_DECLARE_COMPARISON(!=)
+#undef SHADER_DUAL_DECLARE_COMPARISON
+
+    // scalar functions of shader_lib.h, values are the float ones
+    friend FORCEINLINE Dual min(const Dual& a, const Dual& b) { return b.val < a.val ? b : a; }
+    friend FORCEINLINE Dual max(const Dual& a, const Dual& b) { return a.val < b.val ? b : a; }
+    friend FORCEINLINE Dual clamp(const Dual& x, const Dual& inMin, const Dual& inMax) { return min(inMax, max(x, inMin)); }
+    friend FORCEINLINE Dual abs(const Dual& a) { return a.val < 0.f ? -a : a; }
+    friend FORCEINLINE Dual sign(const Dual& a) { return Dual(a.val > 0.f ? 1.f : a.val < 0.f ? -1.f : 0.f); }
+    friend FORCEINLINE Dual floor(const Dual& a) { return Dual(FLOORF_IMPL(a.val)); }
+    friend FORCEINLINE Dual FRAC(const Dual& a) { return a.chain(FRAC_IMPL(a.val), 1.f); }
+    friend FORCEINLINE Dual step(const Dual& edge, const Dual& x) { return Dual(x.val < edge.val ? 0.f : 1.f); }
+    friend FORCEINLINE Dual mod(const Dual& x, const Dual& y) { return x - y * floor(x / y); }
+    friend FORCEINLINE Dual lerp(const Dual& a, const Dual& b, const Dual& x) { return a + (b - a) * x; }
+    friend FORCEINLINE Dual smoothstep(const Dual& edge0, const Dual& edge1, Dual t) {
+        t = clamp((t - edge0) / (edge1 - edge0), Dual(0.f), Dual(1.f)); return t * t * (3.f - 2.f * t); }
+#if LIB_CURRENT_LANGUAGE == LIB_HLSL
+    friend FORCEINLINE Dual saturate(const Dual& a) { return clamp(a, Dual(0.f), Dual(1.f)); }
+#endif
+
+    friend FORCEINLINE Dual sqrt(const Dual& a) { const float r = SQRT_IMPL(a.val); return a.chain(r, 0.5f / r); }
+    friend FORCEINLINE Dual INVERSESQRT(const Dual& a) { const float r = INVERSESQRT_IMPL(a.val); return a.chain(r, -0.5f * r * r * r); }
+    friend FORCEINLINE Dual sin(const Dual& a) { return a.chain(SIN_IMPL(a.val), COS_IMPL(a.val)); }
+    friend FORCEINLINE Dual cos(const Dual& a) { return a.chain(COS_IMPL(a.val), -SIN_IMPL(a.val)); }
+    friend FORCEINLINE Dual atan(const Dual& a) { return a.chain(ATAN_IMPL(a.val), 1.f / (1.f + a.val * a.val)); }
+    friend FORCEINLINE Dual atan(const Dual& y, const Dual& x) {
+        const float inv = 1.f / (x.val * x.val + y.val * y.val); Dual r; r.val = ATAN2_IMPL(y.val, x.val);
+        for (int i = 0; i < N; ++i) r.d[i] = (x.val * y.d[i] - y.val * x.d[i]) * inv;
+        return r; }
+    friend FORCEINLINE Dual exp(const Dual& a) { const float e = EXP_IMPL(a.val); return a.chain(e, e); }
+    friend FORCEINLINE Dual exp2(const Dual& a) { const float e = EXP2_IMPL(a.val); return a.chain(e, e * 0.693147181f); }
+    friend FORCEINLINE Dual log(const Dual& a) { return a.chain(LOG_IMPL(a.val), 1.f / a.val); }
+    friend FORCEINLINE Dual log2(const Dual& a) { return a.chain(LOG2_IMPL(a.val), 1.442695041f / a.val); }
+    // d(x^y) = y x^(y - 1) dx + x^y log(x) dy, the second term only where y varies, log(x) is NaN for x < 0
+    friend FORCEINLINE Dual pow(const Dual& x, const Dual& y) {
+        Dual r = x.chain(POW_IMPL(x.val, y.val), y.val * POW_IMPL(x.val, y.val - 1.f));
+        for (int i = 0; i < N; ++i) if (y.d[i] != 0.f) r.d[i] += r.val * LOG_IMPL(x.val) * y.d[i];
+        return r; }
+};
+
+typedef Dual<1> dual;
+typedef Dual<2> dual2;
+typedef Dual<3> dual3;
+
+// VECTOR FUNCTIONS
+// shader_lib.h ones, calling the Dual friends above
+
+SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(Dual<1>)
+SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(Dual<2>)
+SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(Dual<3>)
+
+// p as the variables to differentiate by, component i is variable i
+FORCEINLINE Vector2_base<dual2> dualVariables(const Vector2_base<float>& p) { return Vector2_base<dual2>(dual2::variable(p.x, 0), dual2::variable(p.y, 1)); }
+FORCEINLINE Vector3_base<dual3> dualVariables(const Vector3_base<float>& p) { return Vector3_base<dual3>(dual3::variable(p.x, 0), dual3::variable(p.y, 1), dual3::variable(p.z, 2)); }
+
+FORCEINLINE Vector2_base<float> gradient(const dual2& f) { return Vector2_base<float>(f.d[0], f.d[1]); }
+FORCEINLINE Vector3_base<float> gradient(const dual3& f) { return Vector3_base<float>(f.d[0], f.d[1], f.d[2]); }
+
+// clang-format on
+
+#endif // SHADER_DUAL_H
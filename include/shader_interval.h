@@ -0,0 +1,140 @@
+#ifndef SHADER_INTERVAL_H
+#define SHADER_INTERVAL_H
+
+#include "shader_lib.h"
+
+// Interval arithmetic. Interval is a range [lo, hi] of floats, every operation returns a range containing
+// all its results for arguments in the argument ranges, so a function templated on the scalar type
+// evaluated on a box returns guaranteed bounds of its values there:
+//
+//   const Interval d = sdf(intervalBox(bMin, bMax)); // sdf(p) is in [d.lo, d.hi] for every p in the box
+//
+// If the bounds exclude 0 there is no surface in the box, whatever the function is, Lipschitz or not.
+// Bounds are conservative, not tight: x * y doesn't know that x and y can be the same variable. x * x is a square
+// when both are the same object (dot(v, v) and length(v) are), x * (x + 1) is wider than its real range.
+// Results are widened by a couple of ulps for rounding, library functions (sin, exp, ...) by their error,
+// sin and cos assume |x| < 8192. NaN bounds never exclude anything.
+// There are no comparisons, branches on values don't work with intervals, use min, max, step, clamp.
+
+// clang-format off
+
+struct Interval {
+    float lo, hi;
+
+    Interval() = default;
+    constexpr FORCEINLINE Interval(float f) : lo(f), hi(f) {}
+    constexpr FORCEINLINE Interval(float lo, float hi) : lo(lo), hi(hi) {}
+
+    // false if the range contains v or bounds are NaN
+    FORCEINLINE bool excludes(float v) const { return lo > v || hi < v; }
+
+    // [lo, hi] widened by rel * |x| + absolute, inf stays inf
+    static FORCEINLINE Interval widened(float lo, float hi, float rel = 2.4e-7f, float absolute = 1.2e-38f) {
+        const float l = lo - (std::abs(lo) * rel + absolute), h = hi + (std::abs(hi) * rel + absolute);
+        return Interval(l == l ? l : lo, h == h ? h : hi); }
+    // error of libm and shader_math.h kernels: a few ulps, sin and cos 1.3e-7 absolute
+    static FORCEINLINE Interval approx(float lo, float hi) { return widened(lo, hi, 1e-6f, 2.5e-7f); }
+
+    friend FORCEINLINE Interval operator-(const Interval& a) { return Interval(-a.hi, -a.lo); }
+    friend FORCEINLINE Interval operator+(const Interval& a, const Interval& b) { return widened(a.lo + b.lo, a.hi + b.hi); }
+    friend FORCEINLINE Interval operator-(const Interval& a, const Interval& b) { return widened(a.lo - b.hi, a.hi - b.lo); }
+    friend FORCEINLINE Interval operator*(const Interval& a, const Interval& b) {
+        if (&a == &b) {
+            // x * x of the same variable is never negative
+            const float l = a.lo * a.lo, h = a.hi * a.hi;
+            return a.lo <= 0.f && a.hi >= 0.f ? widened(0.f, std::max(l, h)) : widened(std::min(l, h), std::max(l, h));
+        }
+        const float p0 = a.lo * b.lo, p1 = a.lo * b.hi, p2 = a.hi * b.lo, p3 = a.hi * b.hi;
+        return widened(std::min({ p0, p1, p2, p3 }), std::max({ p0, p1, p2, p3 })); }
+    // division by a range containing 0 is unbounded
+    friend FORCEINLINE Interval operator/(const Interval& a, const Interval& b) {
+        if (!b.excludes(0.f))
+            return Interval(-ShaderMath::inf, ShaderMath::inf);
+        const float q0 = a.lo / b.lo, q1 = a.lo / b.hi, q2 = a.hi / b.lo, q3 = a.hi / b.hi;
+        return widened(std::min({ q0, q1, q2, q3 }), std::max({ q0, q1, q2, q3 })); }
+
+    FORCEINLINE Interval& operator+=(const Interval& b) { return *this = *this + b; }
+    FORCEINLINE Interval& operator-=(const Interval& b) { return *this = *this - b; }
+    FORCEINLINE Interval& operator*=(const Interval& b) { return *this = *this * b; }
+    FORCEINLINE Interval& operator/=(const Interval& b) { return *this = *this / b; }
+
+    // scalar functions of shader_lib.h, monotonic ones map the bounds
+    friend FORCEINLINE Interval min(const Interval& a, const Interval& b) { return Interval(std::min(a.lo, b.lo), std::min(a.hi, b.hi)); }
+    friend FORCEINLINE Interval max(const Interval& a, const Interval& b) { return Interval(std::max(a.lo, b.lo), std::max(a.hi, b.hi)); }
+    friend FORCEINLINE Interval clamp(const Interval& x, const Interval& inMin, const Interval& inMax) { return min(inMax, max(x, inMin)); }
+    friend FORCEINLINE Interval abs(const Interval& a) {
+        if (a.lo >= 0.f) return a;
+        if (a.hi <= 0.f) return -a;
+        return Interval(0.f, std::max(-a.lo, a.hi)); }
+    friend FORCEINLINE Interval sign(const Interval& a) { return Interval(sign(a.lo), sign(a.hi)); }
+    friend FORCEINLINE Interval floor(const Interval& a) { return Interval(FLOORF_IMPL(a.lo), FLOORF_IMPL(a.hi)); }
+    friend FORCEINLINE Interval FRAC(const Interval& a) {
+        const float f = FLOORF_IMPL(a.lo);
+        if (f != FLOORF_IMPL(a.hi)) return Interval(0.f, 1.f);
+        const Interval r = widened(a.lo - f, a.hi - f);
+        return Interval(std::max(r.lo, 0.f), std::min(r.hi, 1.f)); }
+    // step is 1 for x >= edge
+    friend FORCEINLINE Interval step(const Interval& edge, const Interval& x) { return Interval(x.lo < edge.hi ? 0.f : 1.f, x.hi < edge.lo ? 0.f : 1.f); }
+    friend FORCEINLINE Interval mod(const Interval& x, const Interval& y) {
+        if (y.lo == y.hi && y.lo > 0.f) {
+            // within one period the result is x shifted, otherwise it's anything in [0, y)
+            const float q = FLOORF_IMPL(x.lo / y.lo);
+            if (q != FLOORF_IMPL(x.hi / y.lo)) return Interval(0.f, y.lo);
+            const Interval r = widened(x.lo - q * y.lo, x.hi - q * y.lo, 4.8e-7f);
+            return Interval(std::max(r.lo, 0.f), std::min(r.hi, y.lo));
+        }
+        return x - y * floor(x / y); }
+    friend FORCEINLINE Interval lerp(const Interval& a, const Interval& b, const Interval& x) { return a + (b - a) * x; }
+    // the cubic is increasing on [0, 1]
+    friend FORCEINLINE Interval smoothstep(const Interval& edge0, const Interval& edge1, const Interval& x) {
+        const Interval t = clamp((x - edge0) / (edge1 - edge0), Interval(0.f), Interval(1.f));
+        if (t.lo != t.lo || t.hi != t.hi) return Interval(0.f, 1.f);
+        return widened(t.lo * t.lo * (3.f - 2.f * t.lo), t.hi * t.hi * (3.f - 2.f * t.hi), 1e-6f); }
+#if LIB_CURRENT_LANGUAGE == LIB_HLSL
+    friend FORCEINLINE Interval saturate(const Interval& a) { return clamp(a, Interval(0.f), Interval(1.f)); }
+#endif
+
+    friend FORCEINLINE Interval sqrt(const Interval& a) { return approx(SQRT_IMPL(std::max(a.lo, 0.f)), SQRT_IMPL(std::max(a.hi, 0.f))); }
+    friend FORCEINLINE Interval INVERSESQRT(const Interval& a) {
+        return approx(INVERSESQRT_IMPL(std::max(a.hi, 0.f)), a.lo > 0.f ? INVERSESQRT_IMPL(a.lo) : ShaderMath::inf); }
+    // sin(x + phase), maxima are at pi/2 - phase + 2 pi k, minima at -pi/2 - phase + 2 pi k
+    static FORCEINLINE Interval periodic(const Interval& a, float phase, float fLo, float fHi) {
+        const float twoPi = 2.f * ShaderMath::pi, slack = 1e-6f * (1.f + std::abs(a.hi));
+        if (!(a.hi - a.lo < twoPi)) return Interval(-1.f, 1.f);
+        const float maxAt = 0.5f * ShaderMath::pi - phase, minAt = -0.5f * ShaderMath::pi - phase;
+        const bool hasMax = maxAt + twoPi * std::ceil((a.lo - slack - maxAt) / twoPi) <= a.hi + slack;
+        const bool hasMin = minAt + twoPi * std::ceil((a.lo - slack - minAt) / twoPi) <= a.hi + slack;
+        const Interval r = approx(std::min(fLo, fHi), std::max(fLo, fHi));
+        return Interval(hasMin ? -1.f : std::max(r.lo, -1.f), hasMax ? 1.f : std::min(r.hi, 1.f)); }
+    friend FORCEINLINE Interval sin(const Interval& a) { return periodic(a, 0.f, SIN_IMPL(a.lo), SIN_IMPL(a.hi)); }
+    friend FORCEINLINE Interval cos(const Interval& a) { return periodic(a, 0.5f * ShaderMath::pi, COS_IMPL(a.lo), COS_IMPL(a.hi)); }
+    friend FORCEINLINE Interval atan(const Interval& a) { return approx(ATAN_IMPL(a.lo), ATAN_IMPL(a.hi)); }
+    // a box not containing the origin and not crossing the branch cut (negative x) has extremes at its corners
+    friend FORCEINLINE Interval atan(const Interval& y, const Interval& x) {
+        if (x.lo <= 0.f && !y.excludes(0.f)) return Interval(-ShaderMath::pi, ShaderMath::pi);
+        const float a0 = ATAN2_IMPL(y.lo, x.lo), a1 = ATAN2_IMPL(y.lo, x.hi), a2 = ATAN2_IMPL(y.hi, x.lo), a3 = ATAN2_IMPL(y.hi, x.hi);
+        return approx(std::min({ a0, a1, a2, a3 }), std::max({ a0, a1, a2, a3 })); }
+    friend FORCEINLINE Interval exp(const Interval& a) { return approx(EXP_IMPL(a.lo), EXP_IMPL(a.hi)); }
+    friend FORCEINLINE Interval exp2(const Interval& a) { return approx(EXP2_IMPL(a.lo), EXP2_IMPL(a.hi)); }
+    friend FORCEINLINE Interval log(const Interval& a) { return approx(a.lo > 0.f ? LOG_IMPL(a.lo) : -ShaderMath::inf, LOG_IMPL(a.hi)); }
+    friend FORCEINLINE Interval log2(const Interval& a) { return approx(a.lo > 0.f ? LOG2_IMPL(a.lo) : -ShaderMath::inf, LOG2_IMPL(a.hi)); }
+    // x^y = exp2(y log2(x)) for x >= 0, negative x is undefined in GLSL
+    friend FORCEINLINE Interval pow(const Interval& x, const Interval& y) {
+        const Interval r = exp2(y * log2(Interval(std::max(x.lo, 0.f), std::max(x.hi, 0.f))));
+        return r.lo != r.lo || r.hi != r.hi ? Interval(0.f, ShaderMath::inf) : r; }
+};
+
+// VECTOR FUNCTIONS
+// shader_lib.h ones, calling the Interval friends above
+
+SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(Interval)
+
+// box [lo, hi] as intervals of its coordinates
+FORCEINLINE Vector2_base<Interval> intervalBox(const Vector2_base<float>& lo, const Vector2_base<float>& hi) {
+    return Vector2_base<Interval>(Interval(lo.x, hi.x), Interval(lo.y, hi.y)); }
+FORCEINLINE Vector3_base<Interval> intervalBox(const Vector3_base<float>& lo, const Vector3_base<float>& hi) {
+    return Vector3_base<Interval>(Interval(lo.x, hi.x), Interval(lo.y, hi.y), Interval(lo.z, hi.z)); }
+
+// clang-format on
+
+#endif // SHADER_INTERVAL_H
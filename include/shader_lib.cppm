@@ -0,0 +1,24 @@
+// C++20 module interface of shader_lib.h: `import shader_lib;` instead of #include "shader_lib.h"
+// Vector templates and swizzlers are parsed once, when the module is built, not in every TU.
+// Built by the ShaderLibModule target (-DSHADEREMUL_MODULE=ON, needs CMake 3.28+ and a compiler with module scanning).
+// ENABLE_SWIZZLERS_* / SHADER_SWIZZLERS_HEADER / LIB_CURRENT_LANGUAGE have to be set on the module target,
+// importers can't change them.
+module;
+
+// standard headers shader_lib.h uses, they stay in the global module and are not exported
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+export module shader_lib;
+
+#define SHADER_LIB_MODULE
+export {
+#include "shader_lib.h"
+}
@@ -5,12 +5,18 @@
 #include <cassert>
 #include <cmath> // floorf
 #include <cstdint>
+#include <type_traits>
 
 // swizzlers are .xyz .zyyy things
 // there are a lot of combinations (swizzlers_44, it contains 256 of them)
 // so they've been move in separate headers
 // they are included by default, but you can
 // #define ENABLE_SWIZZLERS_44 0, if it speeds up a compile time
+//
+// or #define SHADER_SWIZZLERS_HEADER "file.h" with SHADER_SWIZZLERS_VEC2/3/4 macros listing union members,
+// then only these swizzlers are declared (and instantiated), ENABLE_SWIZZLERS_* are ignored.
+// cmake/ShaderSwizzlers.cmake generates such a header from the swizzlers used in a target's sources.
+// All TUs of a program must see the same list, vector layout doesn't change.
 
 // clang-format off
 
@@ -28,6 +34,26 @@
 #define LIB_CURRENT_LANGUAGE LIB_GLSL
 #endif
 
+// sin, cos, exp, log, pow, atan: libm (std:: or FMath::) or polynomial approximations from shader_math.h,
+// they have GPU-like error of few ulp, and are vectorized for packets of shader_simd.h
+//
+// LIB_MATH_GPU reproduces GPU behaviour on top of LIB_MATH_FAST: sin/cos reduce the argument in turns (x / 2pi)
+// like GPU hardware, fract() stays below 1, division of vectors, mod and smoothstep multiply by reciprocal,
+// denormals are flushed to zero (ShaderMath::FloatEnvironmentScope, drawImage and march set it).
+// Floats and packets of any width give the same bits, so results don't depend on thread count or SIMD width
+// as long as the compiler doesn't fuse multiply-add (-ffp-contract=off, cmake -DSHADEREMUL_GPU_MATH=ON sets both).
+#define LIB_MATH_STD 0
+#define LIB_MATH_FAST 1
+#define LIB_MATH_GPU 2
+
+#ifndef LIB_CURRENT_MATH
+#define LIB_CURRENT_MATH LIB_MATH_STD
+#endif
+
+#ifdef SHADER_SWIZZLERS_HEADER
+#include SHADER_SWIZZLERS_HEADER
+#endif
+
 #ifndef ENABLE_SWIZZLERS_33
 #define ENABLE_SWIZZLERS_33 1
 #endif
@@ -54,6 +80,17 @@
     #endif
 #endif
 
+// a / b for vector components and library functions, GPUs multiply by reciprocal
+template <typename T>
+FORCEINLINE T DIV_IMPL(const T& a, const T& b)
+{
+#if LIB_CURRENT_MATH == LIB_MATH_GPU
+    if constexpr (!std::is_integral_v<T>)
+        return a * (T(1.f) / b);
+#endif
+    return a / b;
+}
+
 template <typename T, std::size_t N>
 constexpr bool areSwizzlersValid(const T (&arr)[N])
 {
@@ -117,8 +154,11 @@ private:
 template <typename T>
 struct Vector2_base {
     union {
-        struct { T x, y; }; struct { T r, g; }; struct { float s, t; };
+        struct { T x, y; }; struct { T r, g; }; struct { T s, t; };
 
+#ifdef SHADER_SWIZZLERS_HEADER
+        SHADER_SWIZZLERS_VEC2
+#else
         Swiz2<T, 2, 0, 0> xx, rr, ss;
         Swiz2<T, 2, 0, 1> xy, rg, st;
         Swiz2<T, 2, 1, 0> yx, gr, ts;
@@ -149,6 +189,7 @@ struct Vector2_base {
         Swiz4<T, 2, 1, 1, 0, 1> yyxy, ggrg, ttst;
         Swiz4<T, 2, 1, 1, 1, 0> yyyx, gggr, ttts;
         Swiz4<T, 2, 1, 1, 1, 1> yyyy, gggg, tttt;
+#endif
     };
 
     Vector2_base() {}
@@ -180,8 +221,12 @@ struct Vector2_base {
 SHADER_MATH_DECLARE_OPERATOR_Vector2_base(+)
 SHADER_MATH_DECLARE_OPERATOR_Vector2_base(-)
 SHADER_MATH_DECLARE_OPERATOR_Vector2_base(*)
-SHADER_MATH_DECLARE_OPERATOR_Vector2_base(/)
 #undef SHADER_MATH_DECLARE_OPERATOR_Vector2_base
+
+    FORCEINLINE Vector2_base operator/(const Vector2_base& rhs) const { return Vector2_base(DIV_IMPL(x, rhs.x), DIV_IMPL(y, rhs.y)); }
+    FORCEINLINE Vector2_base operator/(T f) const { return Vector2_base(DIV_IMPL(x, f), DIV_IMPL(y, f)); }
+    FORCEINLINE friend Vector2_base operator/(T f, const Vector2_base& v) { return Vector2_base(DIV_IMPL(f, v.x), DIV_IMPL(f, v.y)); }
+    FORCEINLINE Vector2_base& operator/=(const Vector2_base& rhs) { *this = *this / rhs; return *this; }
 };
 static_assert(sizeof(Vector2_base<float>) == 2 * sizeof(float));
 
@@ -190,8 +235,11 @@ static_assert(sizeof(Vector2_base<float>) == 2 * sizeof(float));
 template <typename T>
 struct Vector3_base {
     union {
-        struct { T x, y, z; }; struct { T r, g, b; }; struct { float s, t, p; };
+        struct { T x, y, z; }; struct { T r, g, b; }; struct { T s, t, p; };
 
+#ifdef SHADER_SWIZZLERS_HEADER
+        SHADER_SWIZZLERS_VEC3
+#else
         Swiz2<T, 3, 0, 0> xx, rr, ss;
         Swiz2<T, 3, 0, 1> xy, rg, st;
         Swiz2<T, 3, 0, 2> xz, rb, sp;
@@ -208,6 +256,7 @@ struct Vector3_base {
 
 #if ENABLE_SWIZZLERS_34
 #include "swizzlers/swizzlers_34.h"
+#endif
 #endif
     };
 
@@ -244,8 +293,12 @@ struct Vector3_base {
 SHADER_MATH_DECLARE_OPERATOR_Vector3_base(+)
 SHADER_MATH_DECLARE_OPERATOR_Vector3_base(-)
 SHADER_MATH_DECLARE_OPERATOR_Vector3_base(*)
-SHADER_MATH_DECLARE_OPERATOR_Vector3_base(/)
 #undef SHADER_MATH_DECLARE_OPERATOR_Vector3_base
+
+    FORCEINLINE Vector3_base operator/(const Vector3_base& rhs) const { return Vector3_base(DIV_IMPL(x, rhs.x), DIV_IMPL(y, rhs.y), DIV_IMPL(z, rhs.z)); }
+    FORCEINLINE Vector3_base operator/(T f) const { return Vector3_base(DIV_IMPL(x, f), DIV_IMPL(y, f), DIV_IMPL(z, f)); }
+    FORCEINLINE friend Vector3_base operator/(T f, const Vector3_base& v) { return Vector3_base(DIV_IMPL(f, v.x), DIV_IMPL(f, v.y), DIV_IMPL(f, v.z)); }
+    FORCEINLINE Vector3_base& operator/=(const Vector3_base& rhs) { *this = *this / rhs; return *this; }
 };
 static_assert(sizeof(Vector3_base<float>) == 3 * sizeof(float));
 
@@ -254,8 +307,11 @@ static_assert(sizeof(Vector3_base<float>) == 3 * sizeof(float));
 template <typename T>
 struct Vector4_base {
     union {
-        struct { float x, y, z, w; }; struct { float r, g, b, a; }; struct { float s, t, p, q; };
+        struct { T x, y, z, w; }; struct { T r, g, b, a; }; struct { T s, t, p, q; };
 
+#ifdef SHADER_SWIZZLERS_HEADER
+        SHADER_SWIZZLERS_VEC4
+#else
         Swiz2<T, 4, 0, 0> xx, rr, ss;
         Swiz2<T, 4, 0, 1> xy, rg, st;
         Swiz2<T, 4, 0, 2> xz, rb, sp;
@@ -279,6 +335,7 @@ struct Vector4_base {
 
 #if ENABLE_SWIZZLERS_44
 #include "swizzlers/swizzlers_44.h"
+#endif
 #endif
     };
 
@@ -316,8 +373,12 @@ struct Vector4_base {
 SHADER_MATH_DECLARE_OPERATOR_Vector4_base(+)
 SHADER_MATH_DECLARE_OPERATOR_Vector4_base(-)
 SHADER_MATH_DECLARE_OPERATOR_Vector4_base(*)
-SHADER_MATH_DECLARE_OPERATOR_Vector4_base(/)
 #undef SHADER_MATH_DECLARE_OPERATOR_Vector4_base
+
+    FORCEINLINE Vector4_base operator/(const Vector4_base& rhs) const { return Vector4_base(DIV_IMPL(x, rhs.x), DIV_IMPL(y, rhs.y), DIV_IMPL(z, rhs.z), DIV_IMPL(w, rhs.w)); }
+    FORCEINLINE Vector4_base operator/(T f) const { return Vector4_base(DIV_IMPL(x, f), DIV_IMPL(y, f), DIV_IMPL(z, f), DIV_IMPL(w, f)); }
+    FORCEINLINE friend Vector4_base operator/(T f, const Vector4_base& v) { return Vector4_base(DIV_IMPL(f, v.x), DIV_IMPL(f, v.y), DIV_IMPL(f, v.z), DIV_IMPL(f, v.w)); }
+    FORCEINLINE Vector4_base& operator/=(const Vector4_base& rhs) { *this = *this / rhs; return *this; }
 };
 static_assert(sizeof(Vector4_base<float>) == 4 * sizeof(float));
 
@@ -325,6 +386,10 @@ static_assert(sizeof(Vector4_base<float>) == 4 * sizeof(float));
 //  SWIZZLE IMPL
 //
 
+// scalar argument of swizzle operators doesn't take part in template deduction,
+// so it is converted to the vector's type: 1 + v.xy, 0.5f * packet.xyx
+template <typename T> struct NonDeduced { typedef T type; };
+
 
 // SWIZZLE 2 FUNCTIONS
 
@@ -337,18 +402,18 @@ FORCEINLINE Swiz2<T, Size, X, Y>& Swiz2<T, Size, X, Y>::operator=(const Vector2_
 }
 
 #define SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector2_base(op) \
-template <typename T, uint Size, uint X, uint Y>                                                 \
-FORCEINLINE Vector2_base<T> operator op(const Swiz2<T, Size, X, Y>& s, const Vector2_base<T>& f) \
-{ return Vector2_base<T>(s) op f; }                                                              \
-template <typename T, uint Size, uint X, uint Y>                                                 \
-FORCEINLINE Vector2_base<T> operator op(const Swiz2<T, Size, X, Y>& s, T f)                      \
-{ return Vector2_base<T>(s) op Vector2_base<T>(f); }                                             \
-template <typename T, uint Size, uint X, uint Y>                                                 \
-FORCEINLINE Vector2_base<T> operator op(T f, const Swiz2<T, Size, X, Y>& s)                      \
-{ return Vector2_base<T>(f) op Vector2_base<T>(s); }                                             \
-template <typename T, uint Size, uint X, uint Y>                                                 \
-Swiz2<T, Size, X, Y>& Swiz2<T, Size, X, Y>::operator op##=(const Vector2_base<T>& v)             \
-{ static_assert(areSwizzlersValid({ X, Y })); m[X] op##= v.x, m[Y] op##= v.y; return *this; }
+template <typename T, uint Size, uint X, uint Y>                                                       \
+FORCEINLINE Vector2_base<T> operator op(const Swiz2<T, Size, X, Y>& s, const Vector2_base<T>& f)       \
+{ return Vector2_base<T>(s) op f; }                                                                    \
+template <typename T, uint Size, uint X, uint Y>                                                       \
+FORCEINLINE Vector2_base<T> operator op(const Swiz2<T, Size, X, Y>& s, typename NonDeduced<T>::type f) \
+{ return Vector2_base<T>(s) op Vector2_base<T>(f); }                                                   \
+template <typename T, uint Size, uint X, uint Y>                                                       \
+FORCEINLINE Vector2_base<T> operator op(typename NonDeduced<T>::type f, const Swiz2<T, Size, X, Y>& s) \
+{ return Vector2_base<T>(f) op Vector2_base<T>(s); }                                                   \
+template <typename T, uint Size, uint X, uint Y>                                                       \
+Swiz2<T, Size, X, Y>& Swiz2<T, Size, X, Y>::operator op##=(const Vector2_base<T>& v)                   \
+{ return *this = Vector2_base<T>(*this) op v; }
 
 SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector2_base(+)
 SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector2_base(-)
@@ -367,18 +432,18 @@ FORCEINLINE Swiz3<T, Size, X, Y, Z>& Swiz3<T, Size, X, Y, Z>::operator=(const Ve
 }
 
 #define SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector3_base(op) \
-template <typename T, uint Size, uint X, uint Y, uint Z>                                            \
-FORCEINLINE Vector3_base<T> operator op(const Swiz3<T, Size, X, Y, Z>& s, const Vector3_base<T>& f) \
-{ return Vector3_base<T>(s) op f; }                                                                 \
-template <typename T, uint Size, uint X, uint Y, uint Z>                                            \
-FORCEINLINE Vector3_base<T> operator op(const Swiz3<T, Size, X, Y, Z>& s, T f)                      \
-{ return Vector3_base<T>(s) op Vector3_base<T>(f); }                                                \
-template <typename T, uint Size, uint X, uint Y, uint Z>                                            \
-FORCEINLINE Vector3_base<T> operator op(T f, const Swiz3<T, Size, X, Y, Z>& s)                      \
-{ return Vector3_base<T>(f) op Vector3_base<T>(s); }                                                \
-template <typename T, uint Size, uint X, uint Y, uint Z>                                            \
-Swiz3<T, Size, X, Y, Z>& Swiz3<T, Size, X, Y, Z>::operator op##=(const Vector3_base<T>& v)          \
-{ static_assert(areSwizzlersValid({ X, Y, Z })); m[X] op##= v.x, m[Y] op##= v.y, m[Z] op##= v.z; return *this; }
+template <typename T, uint Size, uint X, uint Y, uint Z>                                                  \
+FORCEINLINE Vector3_base<T> operator op(const Swiz3<T, Size, X, Y, Z>& s, const Vector3_base<T>& f)       \
+{ return Vector3_base<T>(s) op f; }                                                                       \
+template <typename T, uint Size, uint X, uint Y, uint Z>                                                  \
+FORCEINLINE Vector3_base<T> operator op(const Swiz3<T, Size, X, Y, Z>& s, typename NonDeduced<T>::type f) \
+{ return Vector3_base<T>(s) op Vector3_base<T>(f); }                                                      \
+template <typename T, uint Size, uint X, uint Y, uint Z>                                                  \
+FORCEINLINE Vector3_base<T> operator op(typename NonDeduced<T>::type f, const Swiz3<T, Size, X, Y, Z>& s) \
+{ return Vector3_base<T>(f) op Vector3_base<T>(s); }                                                      \
+template <typename T, uint Size, uint X, uint Y, uint Z>                                                  \
+Swiz3<T, Size, X, Y, Z>& Swiz3<T, Size, X, Y, Z>::operator op##=(const Vector3_base<T>& v)                \
+{ return *this = Vector3_base<T>(*this) op v; }
 
 SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector3_base(+)
 SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector3_base(-)
@@ -397,18 +462,18 @@ FORCEINLINE Swiz4<T, Size, X, Y, Z, W>& Swiz4<T, Size, X, Y, Z, W>::operator=(co
 }
 
 #define SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector4_base(op) \
-template <typename T, uint Size, uint X, uint Y, uint Z, uint W>                                       \
-FORCEINLINE Vector4_base<T> operator op(const Swiz4<T, Size, X, Y, Z, W>& s, const Vector4_base<T>& f) \
-{ return Vector4_base<T>(s) op f; }                                                                    \
-template <typename T, uint Size, uint X, uint Y, uint Z, uint W>                                       \
-FORCEINLINE Vector4_base<T> operator op(const Swiz4<T, Size, X, Y, Z, W>& s, T f)                      \
-{ return Vector4_base<T>(s) op Vector4_base<T>(f); }                                                   \
-template <typename T, uint Size, uint X, uint Y, uint Z, uint W>                                       \
-FORCEINLINE Vector4_base<T> operator op(T f, const Swiz4<T, Size, X, Y, Z, W>& s)                      \
-{ return Vector4_base<T>(f) op Vector4_base<T>(s); }                                                   \
-template <typename T, uint Size, uint X, uint Y, uint Z, uint W>                                       \
-Swiz4<T, Size, X, Y, Z, W>& Swiz4<T, Size, X, Y, Z, W>::operator op##=(const Vector4_base<T>& v)       \
-{ static_assert(areSwizzlersValid({ X, Y, Z, W })); m[X] op##= v.x, m[Y] op##= v.y, m[Z] op##= v.z, m[W] op##= v.w; return *this; }
+template <typename T, uint Size, uint X, uint Y, uint Z, uint W>                                             \
+FORCEINLINE Vector4_base<T> operator op(const Swiz4<T, Size, X, Y, Z, W>& s, const Vector4_base<T>& f)       \
+{ return Vector4_base<T>(s) op f; }                                                                          \
+template <typename T, uint Size, uint X, uint Y, uint Z, uint W>                                             \
+FORCEINLINE Vector4_base<T> operator op(const Swiz4<T, Size, X, Y, Z, W>& s, typename NonDeduced<T>::type f) \
+{ return Vector4_base<T>(s) op Vector4_base<T>(f); }                                                         \
+template <typename T, uint Size, uint X, uint Y, uint Z, uint W>                                             \
+FORCEINLINE Vector4_base<T> operator op(typename NonDeduced<T>::type f, const Swiz4<T, Size, X, Y, Z, W>& s) \
+{ return Vector4_base<T>(f) op Vector4_base<T>(s); }                                                         \
+template <typename T, uint Size, uint X, uint Y, uint Z, uint W>                                             \
+Swiz4<T, Size, X, Y, Z, W>& Swiz4<T, Size, X, Y, Z, W>::operator op##=(const Vector4_base<T>& v)             \
+{ return *this = Vector4_base<T>(*this) op v; }
 
 SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector4_base(+)
 SHADER_EMUL_DECLARE_SWIZZLE_OPERATOR_Vector4_base(-)
@@ -456,6 +521,7 @@ struct hash<Vector4_base<T>> {
     typedef Vector3_base<int32_t> uint3;
     typedef Vector4_base<int32_t> uint4;
     #define FRAC frac
+    #define INVERSESQRT rsqrt
 #elif LIB_CURRENT_LANGUAGE == LIB_GLSL
     typedef Vector2_base<float> vec2;
     typedef Vector3_base<float> vec3;
@@ -467,8 +533,11 @@ struct hash<Vector4_base<T>> {
     typedef Vector3_base<uint32_t> uvec3;
     typedef Vector4_base<uint32_t> uvec4;
     #define FRAC fract // glsl: fract(), hlsl: frac()
+    #define INVERSESQRT inversesqrt // glsl: inversesqrt(), hlsl: rsqrt()
 #endif
 
+#include "shader_math.h"
+
 #if LIB_CURRENT_CONTEXT == LIB_UNREAL
     #define CLAMP_IMPL(x, a, b) FMath::Clamp(x, a, b)
     #define FLOORF_IMPL(x) FMath::FloorToFloat(x)
@@ -477,19 +546,61 @@ struct hash<Vector4_base<T>> {
     #define ABS_IMPL(x) FMath::Abs(x)
     #define MIN_IMPL(a, b) FMath::Min(a, b)
     #define MAX_IMPL(a, b) FMath::Max(a, b)
+    #define SQRT_IMPL(x) FMath::Sqrt(x)
 #elif LIB_CURRENT_CONTEXT == LIB_STD
     #define CLAMP_IMPL(x, a, b) std::clamp(x, a, b)
     #define FLOORF_IMPL(x) floorf(x)
+#if LIB_CURRENT_MATH == LIB_MATH_GPU
+    FORCEINLINE float FRAC_IMPL(float x) { return std::min(x - floorf(x), 0.99999994f); } // -1e-9 gives 1 otherwise
+#else
     FORCEINLINE float FRAC_IMPL(float x) { return x - floorf(x); }
+#endif
     template <typename T> FORCEINLINE T LERP_IMPL(T a, T b, T x) { return a + (b - a) * x; }
     #define ABS_IMPL(x) std::abs(x)
     #define MIN_IMPL(a, b) std::min(a, b)
     #define MAX_IMPL(a, b) std::max(a, b)
+    #define SQRT_IMPL(x) std::sqrt(x)
+#endif
+
+#if LIB_CURRENT_MATH == LIB_MATH_FAST || LIB_CURRENT_MATH == LIB_MATH_GPU
+  #if LIB_CURRENT_MATH == LIB_MATH_GPU
+    #define SIN_IMPL(x) ShaderMath::gpuSin(x)
+    #define COS_IMPL(x) ShaderMath::gpuCos(x)
+  #else
+    #define SIN_IMPL(x) ShaderMath::sin(x)
+    #define COS_IMPL(x) ShaderMath::cos(x)
+  #endif
+    #define ATAN_IMPL(x) ShaderMath::atan(x)
+    #define ATAN2_IMPL(y, x) ShaderMath::atan2(y, x)
+    #define EXP_IMPL(x) ShaderMath::exp(x)
+    #define EXP2_IMPL(x) ShaderMath::exp2(x)
+    #define LOG_IMPL(x) ShaderMath::log(x)
+    #define LOG2_IMPL(x) ShaderMath::log2(x)
+    #define POW_IMPL(x, y) ShaderMath::pow(x, y)
+#elif LIB_CURRENT_CONTEXT == LIB_UNREAL
+    #define SIN_IMPL(x) FMath::Sin(x)
+    #define COS_IMPL(x) FMath::Cos(x)
+    #define ATAN_IMPL(x) FMath::Atan(x)
+    #define ATAN2_IMPL(y, x) FMath::Atan2(y, x)
+    #define EXP_IMPL(x) FMath::Exp(x)
+    #define EXP2_IMPL(x) FMath::Exp2(x)
+    #define LOG_IMPL(x) FMath::Loge(x)
+    #define LOG2_IMPL(x) FMath::Log2(x)
+    #define POW_IMPL(x, y) FMath::Pow(x, y)
+#elif LIB_CURRENT_CONTEXT == LIB_STD
     #define SIN_IMPL(x) std::sin(x)
     #define COS_IMPL(x) std::cos(x)
+    #define ATAN_IMPL(x) std::atan(x)
+    #define ATAN2_IMPL(y, x) std::atan2(y, x)
+    #define EXP_IMPL(x) std::exp(x)
+    #define EXP2_IMPL(x) std::exp2(x)
+    #define LOG_IMPL(x) std::log(x)
+    #define LOG2_IMPL(x) std::log2(x)
+    #define POW_IMPL(x, y) std::pow(x, y)
 #endif
 
 // BASIC FUNCTIONS
+// Scalar versions here, vector ones for every scalar type are declared by SHADER_LIB_DECLARE_VECTOR_FUNCTIONS below
 
 #if LIB_CURRENT_LANGUAGE == LIB_HLSL
 FORCEINLINE float               saturate(const float a) { return CLAMP_IMPL(a, 0.f, 1.f); }
@@ -498,88 +609,62 @@ FORCEINLINE Vector3_base<float> saturate(const Vector3_base<float>& a) { return
 FORCEINLINE Vector4_base<float> saturate(const Vector4_base<float>& a) { return Vector4_base<float>(CLAMP_IMPL(a.x, 0.f, 1.f), CLAMP_IMPL(a.y, 0.f, 1.f), CLAMP_IMPL(a.z, 0.f, 1.f), CLAMP_IMPL(a.w, 0.f, 1.f)); }
 #endif
 
-FORCEINLINE float dot(const Vector2_base<float>& a, const Vector2_base<float>& b) { return a.x * b.x + a.y * b.y; }
-FORCEINLINE float dot(const Vector3_base<float>& a, const Vector3_base<float>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
-FORCEINLINE float dot(const Vector4_base<float>& a, const Vector4_base<float>& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
-
-FORCEINLINE float length(const Vector2_base<float>& a) { return std::sqrt(dot(a, a)); }
-FORCEINLINE float length(const Vector3_base<float>& a) { return std::sqrt(dot(a, a)); }
-FORCEINLINE float length(const Vector4_base<float>& a) { return std::sqrt(dot(a, a)); }
-
-FORCEINLINE Vector2_base<float> normalize(const Vector2_base<float>& a) { return a / length(a); }
-FORCEINLINE Vector3_base<float> normalize(const Vector3_base<float>& a) { return a / length(a); }
-FORCEINLINE Vector4_base<float> normalize(const Vector4_base<float>& a) { return a / length(a); }
-
-FORCEINLINE float               FRAC(const float a) { return FRAC_IMPL(a); }
-FORCEINLINE Vector2_base<float> FRAC(const Vector2_base<float>& a) { return Vector2_base<float>(FRAC_IMPL(a.x), FRAC_IMPL(a.y)); }
-FORCEINLINE Vector3_base<float> FRAC(const Vector3_base<float>& a) { return Vector3_base<float>(FRAC_IMPL(a.x), FRAC_IMPL(a.y), FRAC_IMPL(a.z)); }
-FORCEINLINE Vector4_base<float> FRAC(const Vector4_base<float>& a) { return Vector4_base<float>(FRAC_IMPL(a.x), FRAC_IMPL(a.y), FRAC_IMPL(a.z), FRAC_IMPL(a.w)); }
-
-FORCEINLINE float               floor(const float a) { return FLOORF_IMPL(a); }
-FORCEINLINE Vector2_base<float> floor(const Vector2_base<float>& a) { return Vector2_base<float>(FLOORF_IMPL(a.x), FLOORF_IMPL(a.y)); }
-FORCEINLINE Vector3_base<float> floor(const Vector3_base<float>& a) { return Vector3_base<float>(FLOORF_IMPL(a.x), FLOORF_IMPL(a.y), FLOORF_IMPL(a.z)); }
-FORCEINLINE Vector4_base<float> floor(const Vector4_base<float>& a) { return Vector4_base<float>(FLOORF_IMPL(a.x), FLOORF_IMPL(a.y), FLOORF_IMPL(a.z), FLOORF_IMPL(a.w)); }
-
-FORCEINLINE float               lerp(const float a, const float b, const float x) { return LERP_IMPL(a, b, x); }
-FORCEINLINE Vector2_base<float> lerp(const Vector2_base<float>& a, const Vector2_base<float>& b, const Vector2_base<float>& x) { return LERP_IMPL(a, b, x); }
-FORCEINLINE Vector3_base<float> lerp(const Vector3_base<float>& a, const Vector3_base<float>& b, const Vector3_base<float>& x) { return LERP_IMPL(a, b, x); }
-FORCEINLINE Vector4_base<float> lerp(const Vector4_base<float>& a, const Vector4_base<float>& b, const Vector4_base<float>& x) { return LERP_IMPL(a, b, x); }
-
+FORCEINLINE float FRAC(const float a) { return FRAC_IMPL(a); }
+FORCEINLINE float floor(const float a) { return FLOORF_IMPL(a); }
+FORCEINLINE float lerp(const float a, const float b, const float x) { return LERP_IMPL(a, b, x); }
+
+#if LIB_CURRENT_CONTEXT == LIB_STD && !defined(SHADER_LIB_MODULE)
+// <stdlib.h> (included by <immintrin.h> as well) brings std::abs overloads to the global namespace,
+// own abs(float) would conflict with them, so they are used for scalars.
+// The module interface (shader_lib.cppm) defines SHADER_LIB_MODULE and exports own abs(float) instead,
+// std::abs can't be re-exported unambiguously from a module by GCC
+#include <stdlib.h>
+using std::abs;
+#else
 // abs can conflict with std-s ones, if parameter type is not float.
 // abs(3.0) - ambigious, abs(3.f) - fine
-FORCEINLINE float               abs(const float v) { return ABS_IMPL(v); }
-FORCEINLINE Vector2_base<float> abs(const Vector2_base<float>& v) { return Vector2_base<float>(ABS_IMPL(v.x), ABS_IMPL(v.y)); }
-FORCEINLINE Vector3_base<float> abs(const Vector3_base<float>& v) { return Vector3_base<float>(ABS_IMPL(v.x), ABS_IMPL(v.y), ABS_IMPL(v.z)); }
-FORCEINLINE Vector4_base<float> abs(const Vector4_base<float>& v) { return Vector4_base<float>(ABS_IMPL(v.x), ABS_IMPL(v.y), ABS_IMPL(v.z), ABS_IMPL(v.z)); }
-
-FORCEINLINE float               sign(const float v) { return v > 0.f ? 1.f : v < 0.f ? -1.f : 0.f; }
-FORCEINLINE Vector2_base<float> sign(const Vector2_base<float>& v) { return Vector2_base<float>(sign(v.x), sign(v.y)); }
-FORCEINLINE Vector3_base<float> sign(const Vector3_base<float>& v) { return Vector3_base<float>(sign(v.x), sign(v.y), sign(v.z)); }
-FORCEINLINE Vector4_base<float> sign(const Vector4_base<float>& v) { return Vector4_base<float>(sign(v.x), sign(v.y), sign(v.z), sign(v.w)); }
-
-FORCEINLINE float               min(const float a, const float b) { return MIN_IMPL(a, b); }
-FORCEINLINE Vector2_base<float> min(const Vector2_base<float>& a, const Vector2_base<float>& b) { return Vector2_base<float>(MIN_IMPL(a.x, b.x), MIN_IMPL(a.y, b.y)); }
-FORCEINLINE Vector3_base<float> min(const Vector3_base<float>& a, const Vector3_base<float>& b) { return Vector3_base<float>(MIN_IMPL(a.x, b.x), MIN_IMPL(a.y, b.y), MIN_IMPL(a.z, b.z)); }
-FORCEINLINE Vector4_base<float> min(const Vector4_base<float>& a, const Vector4_base<float>& b) { return Vector4_base<float>(MIN_IMPL(a.x, b.x), MIN_IMPL(a.y, b.y), MIN_IMPL(a.z, b.z), MIN_IMPL(a.w, b.w)); }
-
-FORCEINLINE float               max(const float a, const float b) { return MAX_IMPL(a, b); }
-FORCEINLINE Vector2_base<float> max(const Vector2_base<float>& a, const Vector2_base<float>& b) { return Vector2_base<float>(MAX_IMPL(a.x, b.x), MAX_IMPL(a.y, b.y)); }
-FORCEINLINE Vector3_base<float> max(const Vector3_base<float>& a, const Vector3_base<float>& b) { return Vector3_base<float>(MAX_IMPL(a.x, b.x), MAX_IMPL(a.y, b.y), MAX_IMPL(a.z, b.z)); }
-FORCEINLINE Vector4_base<float> max(const Vector4_base<float>& a, const Vector4_base<float>& b) { return Vector4_base<float>(MAX_IMPL(a.x, b.x), MAX_IMPL(a.y, b.y), MAX_IMPL(a.z, b.z), MAX_IMPL(a.w, b.w)); }
-
-FORCEINLINE float               clamp(const float x, const float inMin, const float inMax) { return min(inMax, max(x, inMin)); }
-FORCEINLINE Vector2_base<float> clamp(const Vector2_base<float>& x, const Vector2_base<float>& inMin, const Vector2_base<float>& inMax) { return min(inMax, max(x, inMin)); }
-FORCEINLINE Vector3_base<float> clamp(const Vector3_base<float>& x, const Vector3_base<float>& inMin, const Vector3_base<float>& inMax) { return min(inMax, max(x, inMin)); }
-FORCEINLINE Vector4_base<float> clamp(const Vector4_base<float>& x, const Vector4_base<float>& inMin, const Vector4_base<float>& inMax) { return min(inMax, max(x, inMin)); }
-
-// template?
-FORCEINLINE float smoothstep(const float edge0, const float edge1, float t) {
-    t = clamp((t - edge0) / (edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }
+FORCEINLINE float abs(const float v) { return ABS_IMPL(v); }
+#endif
 
-FORCEINLINE Vector2_base<float> smoothstep(const Vector2_base<float>& edge0, const Vector2_base<float>& edge1, Vector2_base<float> t) {
-    t = clamp((t - edge0) / (edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }
+FORCEINLINE float sign(const float v) { return v > 0.f ? 1.f : v < 0.f ? -1.f : 0.f; }
+FORCEINLINE float min(const float a, const float b) { return MIN_IMPL(a, b); }
+FORCEINLINE float max(const float a, const float b) { return MAX_IMPL(a, b); }
+FORCEINLINE float clamp(const float x, const float inMin, const float inMax) { return min(inMax, max(x, inMin)); }
 
-FORCEINLINE Vector3_base<float> smoothstep(const Vector3_base<float>& edge0, const Vector3_base<float>& edge1, Vector3_base<float> t) {
-    t = clamp((t - edge0) / (edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }
+// glsl mod, x - y * floor(x / y), result has sign of y (hlsl fmod and C fmod have sign of x)
+FORCEINLINE float mod(const float x, const float y) { return x - y * FLOORF_IMPL(DIV_IMPL(x, y)); }
 
-FORCEINLINE Vector4_base<float> smoothstep(const Vector4_base<float>& edge0, const Vector4_base<float>& edge1, Vector4_base<float> t) {
-    t = clamp((t - edge0) / (edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }
+// 0 if x < edge, 1 otherwise
+FORCEINLINE float step(const float edge, const float x) { return x < edge ? 0.f : 1.f; }
+
+FORCEINLINE float smoothstep(const float edge0, const float edge1, float t) {
+    t = clamp(DIV_IMPL(t - edge0, edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }
 
 // TRIGONOMETRY
 // Trigonometry finctions have different implementations in CPU and GPU, and differ between GPU
 // Creating noise function fract(5432.1 * sin(x*2345.6)...) can lead to different result
 
 FORCEINLINE float sin(const float v) { return SIN_IMPL(v); }
-FORCEINLINE Vector2_base<float> sin(const Vector2_base<float>& v) { return Vector2_base<float>(SIN_IMPL(v.x), SIN_IMPL(v.y)); }
-FORCEINLINE Vector3_base<float> sin(const Vector3_base<float>& v) { return Vector3_base<float>(SIN_IMPL(v.x), SIN_IMPL(v.y), SIN_IMPL(v.z)); }
-FORCEINLINE Vector4_base<float> sin(const Vector4_base<float>& v) { return Vector4_base<float>(SIN_IMPL(v.x), SIN_IMPL(v.y), SIN_IMPL(v.z), SIN_IMPL(v.z)); }
-
 FORCEINLINE float cos(const float v) { return COS_IMPL(v); }
-FORCEINLINE Vector2_base<float> cos(const Vector2_base<float>& v) { return Vector2_base<float>(COS_IMPL(v.x), COS_IMPL(v.y)); }
-FORCEINLINE Vector3_base<float> cos(const Vector3_base<float>& v) { return Vector3_base<float>(COS_IMPL(v.x), COS_IMPL(v.y), COS_IMPL(v.z)); }
-FORCEINLINE Vector4_base<float> cos(const Vector4_base<float>& v) { return Vector4_base<float>(COS_IMPL(v.x), COS_IMPL(v.y), COS_IMPL(v.z), COS_IMPL(v.z)); }
+FORCEINLINE float atan(const float v) { return ATAN_IMPL(v); }
+
+// glsl atan(y, x) is atan2(y, x), hlsl has atan2(y, x)
+FORCEINLINE float atan(const float y, const float x) { return ATAN2_IMPL(y, x); }
+#if LIB_CURRENT_LANGUAGE == LIB_HLSL
+FORCEINLINE float atan2(const float y, const float x) { return ATAN2_IMPL(y, x); }
+#endif
+
+// EXPONENTIAL
+
+FORCEINLINE float INVERSESQRT_IMPL(const float v) { return 1.f / SQRT_IMPL(v); }
 
-FORCEINLINE float atan(float x, float y) { return std::atan2(x, y); }
+FORCEINLINE float exp(const float v) { return EXP_IMPL(v); }
+FORCEINLINE float exp2(const float v) { return EXP2_IMPL(v); }
+FORCEINLINE float log(const float v) { return LOG_IMPL(v); }
+FORCEINLINE float log2(const float v) { return LOG2_IMPL(v); }
+FORCEINLINE float sqrt(const float v) { return SQRT_IMPL(v); }
+FORCEINLINE float INVERSESQRT(const float v) { return INVERSESQRT_IMPL(v); }
+FORCEINLINE float pow(const float x, const float y) { return POW_IMPL(x, y); }
 
 struct mat3 {
     FORCEINLINE mat3(float f0, float f1, float f2, float f3, float f4, float f5, float f6, float f7, float f8) {
@@ -597,13 +682,135 @@ private:
     Vector3_base<float> m[3];
 };
 
-FORCEINLINE Vector3_base<float> operator*(const mat3& m, const Vector3_base<float>& v)
-{
-    return Vector3_base<float>(
-        m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z,
-        m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z,
-        m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z);
-}
+// VECTOR FUNCTIONS
+// Component-wise functions of Vector2/3/4_base<T> for scalar type T, they call T's scalar functions:
+// the float ones above, FloatPacket friends (shader_simd.h), Dual friends (shader_dual.h) or Interval ones (shader_interval.h).
+// Not templates, so arguments convert to vectors like in shaders: clamp(v, 0.f, 1.f), max(v, 0.5f),
+// while a template couldn't deduce T from them. float -> Vector3_base<P> of a packet takes two conversions,
+// so clamp, mod and step have scalar overloads as well.
+
+#define SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(T) \
+FORCEINLINE T dot(const Vector2_base<T>& a, const Vector2_base<T>& b) { return a.x * b.x + a.y * b.y; }                                                                                  \
+FORCEINLINE T dot(const Vector3_base<T>& a, const Vector3_base<T>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }                                                                      \
+FORCEINLINE T dot(const Vector4_base<T>& a, const Vector4_base<T>& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }                                                          \
+                                                                                                                                                                                        \
+FORCEINLINE T length(const Vector2_base<T>& a) { return sqrt(dot(a, a)); }                                                                                                              \
+FORCEINLINE T length(const Vector3_base<T>& a) { return sqrt(dot(a, a)); }                                                                                                              \
+FORCEINLINE T length(const Vector4_base<T>& a) { return sqrt(dot(a, a)); }                                                                                                              \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> normalize(const Vector2_base<T>& a) { return a / length(a); }                                                                                               \
+FORCEINLINE Vector3_base<T> normalize(const Vector3_base<T>& a) { return a / length(a); }                                                                                               \
+FORCEINLINE Vector4_base<T> normalize(const Vector4_base<T>& a) { return a / length(a); }                                                                                               \
+                                                                                                                                                                                        \
+FORCEINLINE Vector3_base<T> cross(const Vector3_base<T>& a, const Vector3_base<T>& b) { return Vector3_base<T>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }  \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> FRAC(const Vector2_base<T>& a) { return Vector2_base<T>(FRAC(a.x), FRAC(a.y)); }                                                                            \
+FORCEINLINE Vector3_base<T> FRAC(const Vector3_base<T>& a) { return Vector3_base<T>(FRAC(a.x), FRAC(a.y), FRAC(a.z)); }                                                                 \
+FORCEINLINE Vector4_base<T> FRAC(const Vector4_base<T>& a) { return Vector4_base<T>(FRAC(a.x), FRAC(a.y), FRAC(a.z), FRAC(a.w)); }                                                      \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> floor(const Vector2_base<T>& a) { return Vector2_base<T>(floor(a.x), floor(a.y)); }                                                                         \
+FORCEINLINE Vector3_base<T> floor(const Vector3_base<T>& a) { return Vector3_base<T>(floor(a.x), floor(a.y), floor(a.z)); }                                                             \
+FORCEINLINE Vector4_base<T> floor(const Vector4_base<T>& a) { return Vector4_base<T>(floor(a.x), floor(a.y), floor(a.z), floor(a.w)); }                                                 \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> lerp(const Vector2_base<T>& a, const Vector2_base<T>& b, const Vector2_base<T>& x) { return a + (b - a) * x; }                                              \
+FORCEINLINE Vector3_base<T> lerp(const Vector3_base<T>& a, const Vector3_base<T>& b, const Vector3_base<T>& x) { return a + (b - a) * x; }                                              \
+FORCEINLINE Vector4_base<T> lerp(const Vector4_base<T>& a, const Vector4_base<T>& b, const Vector4_base<T>& x) { return a + (b - a) * x; }                                              \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> abs(const Vector2_base<T>& v) { return Vector2_base<T>(abs(v.x), abs(v.y)); }                                                                               \
+FORCEINLINE Vector3_base<T> abs(const Vector3_base<T>& v) { return Vector3_base<T>(abs(v.x), abs(v.y), abs(v.z)); }                                                                     \
+FORCEINLINE Vector4_base<T> abs(const Vector4_base<T>& v) { return Vector4_base<T>(abs(v.x), abs(v.y), abs(v.z), abs(v.w)); }                                                           \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> sign(const Vector2_base<T>& v) { return Vector2_base<T>(sign(v.x), sign(v.y)); }                                                                            \
+FORCEINLINE Vector3_base<T> sign(const Vector3_base<T>& v) { return Vector3_base<T>(sign(v.x), sign(v.y), sign(v.z)); }                                                                 \
+FORCEINLINE Vector4_base<T> sign(const Vector4_base<T>& v) { return Vector4_base<T>(sign(v.x), sign(v.y), sign(v.z), sign(v.w)); }                                                      \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> min(const Vector2_base<T>& a, const Vector2_base<T>& b) { return Vector2_base<T>(min(a.x, b.x), min(a.y, b.y)); }                                           \
+FORCEINLINE Vector3_base<T> min(const Vector3_base<T>& a, const Vector3_base<T>& b) { return Vector3_base<T>(min(a.x, b.x), min(a.y, b.y), min(a.z, b.z)); }                            \
+FORCEINLINE Vector4_base<T> min(const Vector4_base<T>& a, const Vector4_base<T>& b) { return Vector4_base<T>(min(a.x, b.x), min(a.y, b.y), min(a.z, b.z), min(a.w, b.w)); }             \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> max(const Vector2_base<T>& a, const Vector2_base<T>& b) { return Vector2_base<T>(max(a.x, b.x), max(a.y, b.y)); }                                           \
+FORCEINLINE Vector3_base<T> max(const Vector3_base<T>& a, const Vector3_base<T>& b) { return Vector3_base<T>(max(a.x, b.x), max(a.y, b.y), max(a.z, b.z)); }                            \
+FORCEINLINE Vector4_base<T> max(const Vector4_base<T>& a, const Vector4_base<T>& b) { return Vector4_base<T>(max(a.x, b.x), max(a.y, b.y), max(a.z, b.z), max(a.w, b.w)); }             \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> clamp(const Vector2_base<T>& x, const Vector2_base<T>& inMin, const Vector2_base<T>& inMax) { return min(inMax, max(x, inMin)); }                           \
+FORCEINLINE Vector3_base<T> clamp(const Vector3_base<T>& x, const Vector3_base<T>& inMin, const Vector3_base<T>& inMax) { return min(inMax, max(x, inMin)); }                           \
+FORCEINLINE Vector4_base<T> clamp(const Vector4_base<T>& x, const Vector4_base<T>& inMin, const Vector4_base<T>& inMax) { return min(inMax, max(x, inMin)); }                           \
+FORCEINLINE Vector2_base<T> clamp(const Vector2_base<T>& x, const T& inMin, const T& inMax) { return clamp(x, Vector2_base<T>(inMin), Vector2_base<T>(inMax)); }                         \
+FORCEINLINE Vector3_base<T> clamp(const Vector3_base<T>& x, const T& inMin, const T& inMax) { return clamp(x, Vector3_base<T>(inMin), Vector3_base<T>(inMax)); }                         \
+FORCEINLINE Vector4_base<T> clamp(const Vector4_base<T>& x, const T& inMin, const T& inMax) { return clamp(x, Vector4_base<T>(inMin), Vector4_base<T>(inMax)); }                         \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> smoothstep(const Vector2_base<T>& edge0, const Vector2_base<T>& edge1, Vector2_base<T> t) {                                                                  \
+    t = clamp((t - edge0) / (edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }                                                                                               \
+FORCEINLINE Vector3_base<T> smoothstep(const Vector3_base<T>& edge0, const Vector3_base<T>& edge1, Vector3_base<T> t) {                                                                  \
+    t = clamp((t - edge0) / (edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }                                                                                               \
+FORCEINLINE Vector4_base<T> smoothstep(const Vector4_base<T>& edge0, const Vector4_base<T>& edge1, Vector4_base<T> t) {                                                                  \
+    t = clamp((t - edge0) / (edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }                                                                                               \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> sin(const Vector2_base<T>& v) { return Vector2_base<T>(sin(v.x), sin(v.y)); }                                                                               \
+FORCEINLINE Vector3_base<T> sin(const Vector3_base<T>& v) { return Vector3_base<T>(sin(v.x), sin(v.y), sin(v.z)); }                                                                     \
+FORCEINLINE Vector4_base<T> sin(const Vector4_base<T>& v) { return Vector4_base<T>(sin(v.x), sin(v.y), sin(v.z), sin(v.w)); }                                                           \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> cos(const Vector2_base<T>& v) { return Vector2_base<T>(cos(v.x), cos(v.y)); }                                                                               \
+FORCEINLINE Vector3_base<T> cos(const Vector3_base<T>& v) { return Vector3_base<T>(cos(v.x), cos(v.y), cos(v.z)); }                                                                     \
+FORCEINLINE Vector4_base<T> cos(const Vector4_base<T>& v) { return Vector4_base<T>(cos(v.x), cos(v.y), cos(v.z), cos(v.w)); }                                                           \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> atan(const Vector2_base<T>& v) { return Vector2_base<T>(atan(v.x), atan(v.y)); }                                                                            \
+FORCEINLINE Vector3_base<T> atan(const Vector3_base<T>& v) { return Vector3_base<T>(atan(v.x), atan(v.y), atan(v.z)); }                                                                 \
+FORCEINLINE Vector4_base<T> atan(const Vector4_base<T>& v) { return Vector4_base<T>(atan(v.x), atan(v.y), atan(v.z), atan(v.w)); }                                                      \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> atan(const Vector2_base<T>& y, const Vector2_base<T>& x) { return Vector2_base<T>(atan(y.x, x.x), atan(y.y, x.y)); }                                        \
+FORCEINLINE Vector3_base<T> atan(const Vector3_base<T>& y, const Vector3_base<T>& x) { return Vector3_base<T>(atan(y.x, x.x), atan(y.y, x.y), atan(y.z, x.z)); }                        \
+FORCEINLINE Vector4_base<T> atan(const Vector4_base<T>& y, const Vector4_base<T>& x) { return Vector4_base<T>(atan(y.x, x.x), atan(y.y, x.y), atan(y.z, x.z), atan(y.w, x.w)); }        \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> exp(const Vector2_base<T>& v) { return Vector2_base<T>(exp(v.x), exp(v.y)); }                                                                               \
+FORCEINLINE Vector3_base<T> exp(const Vector3_base<T>& v) { return Vector3_base<T>(exp(v.x), exp(v.y), exp(v.z)); }                                                                     \
+FORCEINLINE Vector4_base<T> exp(const Vector4_base<T>& v) { return Vector4_base<T>(exp(v.x), exp(v.y), exp(v.z), exp(v.w)); }                                                           \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> exp2(const Vector2_base<T>& v) { return Vector2_base<T>(exp2(v.x), exp2(v.y)); }                                                                            \
+FORCEINLINE Vector3_base<T> exp2(const Vector3_base<T>& v) { return Vector3_base<T>(exp2(v.x), exp2(v.y), exp2(v.z)); }                                                                 \
+FORCEINLINE Vector4_base<T> exp2(const Vector4_base<T>& v) { return Vector4_base<T>(exp2(v.x), exp2(v.y), exp2(v.z), exp2(v.w)); }                                                      \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> log(const Vector2_base<T>& v) { return Vector2_base<T>(log(v.x), log(v.y)); }                                                                               \
+FORCEINLINE Vector3_base<T> log(const Vector3_base<T>& v) { return Vector3_base<T>(log(v.x), log(v.y), log(v.z)); }                                                                     \
+FORCEINLINE Vector4_base<T> log(const Vector4_base<T>& v) { return Vector4_base<T>(log(v.x), log(v.y), log(v.z), log(v.w)); }                                                           \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> log2(const Vector2_base<T>& v) { return Vector2_base<T>(log2(v.x), log2(v.y)); }                                                                            \
+FORCEINLINE Vector3_base<T> log2(const Vector3_base<T>& v) { return Vector3_base<T>(log2(v.x), log2(v.y), log2(v.z)); }                                                                 \
+FORCEINLINE Vector4_base<T> log2(const Vector4_base<T>& v) { return Vector4_base<T>(log2(v.x), log2(v.y), log2(v.z), log2(v.w)); }                                                      \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> sqrt(const Vector2_base<T>& v) { return Vector2_base<T>(sqrt(v.x), sqrt(v.y)); }                                                                            \
+FORCEINLINE Vector3_base<T> sqrt(const Vector3_base<T>& v) { return Vector3_base<T>(sqrt(v.x), sqrt(v.y), sqrt(v.z)); }                                                                 \
+FORCEINLINE Vector4_base<T> sqrt(const Vector4_base<T>& v) { return Vector4_base<T>(sqrt(v.x), sqrt(v.y), sqrt(v.z), sqrt(v.w)); }                                                      \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> INVERSESQRT(const Vector2_base<T>& v) { return Vector2_base<T>(INVERSESQRT(v.x), INVERSESQRT(v.y)); }                                                       \
+FORCEINLINE Vector3_base<T> INVERSESQRT(const Vector3_base<T>& v) { return Vector3_base<T>(INVERSESQRT(v.x), INVERSESQRT(v.y), INVERSESQRT(v.z)); }                                     \
+FORCEINLINE Vector4_base<T> INVERSESQRT(const Vector4_base<T>& v) { return Vector4_base<T>(INVERSESQRT(v.x), INVERSESQRT(v.y), INVERSESQRT(v.z), INVERSESQRT(v.w)); }                   \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> pow(const Vector2_base<T>& x, const Vector2_base<T>& y) { return Vector2_base<T>(pow(x.x, y.x), pow(x.y, y.y)); }                                           \
+FORCEINLINE Vector3_base<T> pow(const Vector3_base<T>& x, const Vector3_base<T>& y) { return Vector3_base<T>(pow(x.x, y.x), pow(x.y, y.y), pow(x.z, y.z)); }                            \
+FORCEINLINE Vector4_base<T> pow(const Vector4_base<T>& x, const Vector4_base<T>& y) { return Vector4_base<T>(pow(x.x, y.x), pow(x.y, y.y), pow(x.z, y.z), pow(x.w, y.w)); }             \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> mod(const Vector2_base<T>& x, const Vector2_base<T>& y) { return Vector2_base<T>(mod(x.x, y.x), mod(x.y, y.y)); }                                           \
+FORCEINLINE Vector3_base<T> mod(const Vector3_base<T>& x, const Vector3_base<T>& y) { return Vector3_base<T>(mod(x.x, y.x), mod(x.y, y.y), mod(x.z, y.z)); }                            \
+FORCEINLINE Vector4_base<T> mod(const Vector4_base<T>& x, const Vector4_base<T>& y) { return Vector4_base<T>(mod(x.x, y.x), mod(x.y, y.y), mod(x.z, y.z), mod(x.w, y.w)); }             \
+FORCEINLINE Vector2_base<T> mod(const Vector2_base<T>& x, const T& y) { return mod(x, Vector2_base<T>(y)); }                                                                            \
+FORCEINLINE Vector3_base<T> mod(const Vector3_base<T>& x, const T& y) { return mod(x, Vector3_base<T>(y)); }                                                                            \
+FORCEINLINE Vector4_base<T> mod(const Vector4_base<T>& x, const T& y) { return mod(x, Vector4_base<T>(y)); }                                                                            \
+                                                                                                                                                                                        \
+FORCEINLINE Vector2_base<T> step(const Vector2_base<T>& edge, const Vector2_base<T>& x) { return Vector2_base<T>(step(edge.x, x.x), step(edge.y, x.y)); }                               \
+FORCEINLINE Vector3_base<T> step(const Vector3_base<T>& edge, const Vector3_base<T>& x) { return Vector3_base<T>(step(edge.x, x.x), step(edge.y, x.y), step(edge.z, x.z)); }            \
+FORCEINLINE Vector4_base<T> step(const Vector4_base<T>& edge, const Vector4_base<T>& x) { return Vector4_base<T>(step(edge.x, x.x), step(edge.y, x.y), step(edge.z, x.z), step(edge.w, x.w)); }\
+FORCEINLINE Vector2_base<T> step(const T& edge, const Vector2_base<T>& x) { return step(Vector2_base<T>(edge), x); }                                                                     \
+FORCEINLINE Vector3_base<T> step(const T& edge, const Vector3_base<T>& x) { return step(Vector3_base<T>(edge), x); }                                                                     \
+FORCEINLINE Vector4_base<T> step(const T& edge, const Vector4_base<T>& x) { return step(Vector4_base<T>(edge), x); }                                                                     \
+                                                                                                                                                                                        \
+FORCEINLINE Vector3_base<T> operator*(const mat3& m, const Vector3_base<T>& v) {                                                                                                        \
+    return Vector3_base<T>(                                                                                                                                                             \
+        m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z,                                                                                                                                  \
+        m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z,                                                                                                                                  \
+        m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z); }
+
+SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(float)
 
 #define STR_HELPER(x) #x
 #define STR(x) STR_HELPER(x)
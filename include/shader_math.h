@@ -0,0 +1,183 @@
+#ifndef SHADER_MATH_H
+#define SHADER_MATH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring> // memcpy
+#include <limits>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <xmmintrin.h> // _mm_setcsr
+#endif
+
+// Polynomial approximations of transcendental functions, used for sin, cos, exp, log, pow, atan
+// when LIB_CURRENT_MATH == LIB_MATH_FAST (see shader_lib.h). Error is in the range GPUs guarantee,
+// not correctly rounded like libm.
+//
+// Kernels are templates without branches, T is float or FloatPacket<N> (shader_simd.h), so packets
+// evaluate all lanes with vector instructions. T has to provide floor, abs, select(mask, a, b),
+// pow2i, exponent and mantissa: float ones are below, packet ones are FloatPacket friends.
+//
+// Max error against double precision reference (bench/bench_math.cpp measures it):
+//   sin, cos      2 ulp in [-pi, pi], absolute error 1.3e-7 for |x| < 8192
+//   exp, exp2     1 ulp
+//   log, log2     2 ulp, denormals are treated as 0
+//   atan, atan2   4 ulp
+//   pow           exp2(y * log2(x)) like GPUs do, relative error grows with |y * log2(x)|
+//
+// Inputs out of the domain give the same inf/NaN as libm.
+
+// clang-format off
+
+namespace ShaderMath {
+
+// scalar versions of the primitives, packets have them as friends
+FORCEINLINE float floor(const float x) { return floorf(x); }
+FORCEINLINE float abs(const float x) { return fabsf(x); }
+FORCEINLINE float select(const bool mask, const float a, const float b) { return mask ? a : b; }
+
+// 2^n, n is integral, 2^n is 0 and inf out of [-126, 127]
+FORCEINLINE float pow2i(const float n) {
+    const float clamped = std::min(128.f, std::max(-127.f, n)); // NaN gives -127
+    const uint32_t bits = uint32_t(int32_t(clamped) + 127) << 23;
+    float r; memcpy(&r, &bits, sizeof(r)); return r; }
+
+// x = mantissa(x) * 2^exponent(x), mantissa in [1, 2), for positive normal x
+FORCEINLINE float exponent(const float x) {
+    uint32_t bits; memcpy(&bits, &x, sizeof(bits)); return float(int32_t((bits >> 23) & 0xff) - 127); }
+FORCEINLINE float mantissa(const float x) {
+    uint32_t bits; memcpy(&bits, &x, sizeof(bits)); bits = (bits & 0x007fffff) | 0x3f800000;
+    float r; memcpy(&r, &bits, sizeof(r)); return r; }
+
+inline constexpr float pi = 3.14159265358979f;
+inline constexpr float inf = std::numeric_limits<float>::infinity();
+inline constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+
+// sin(x) for |x| <= pi/2, odd minimax polynomial
+template <typename T> FORCEINLINE T sinReduced(const T& x) {
+    const T x2 = x * x;
+    return x + x * x2 * (-1.66666666e-1f + x2 * (8.33333103e-3f + x2 * (-1.98408593e-4f + x2 * (2.75249802e-6f + x2 * -2.38824873e-8f)))); }
+
+// x - k * pi in three parts (Cody-Waite), first two are exact for |k| < 2^15
+template <typename T> FORCEINLINE T reducePi(const T& x, const T& k) {
+    return ((x - k * 3.140625f) - k * 9.67502593994140625e-4f) - k * 1.509957990978376432e-7f; }
+
+// (-1)^k for integral k
+template <typename T> FORCEINLINE T parity(const T& k) {
+    const T h = k * 0.5f; return 1.f - 4.f * (h - floor(h)); }
+
+template <typename T> FORCEINLINE T sin(const T& x) {
+    const T k = floor(x * (1.f / pi) + 0.5f);
+    return sinReduced(reducePi(x, k)) * parity(k); }
+
+// cos(x) = -(-1)^n * sin(x - (n + 0.5) * pi)
+template <typename T> FORCEINLINE T cos(const T& x) {
+    const T n = floor(x * (1.f / pi));
+    return sinReduced(reducePi(x, n + 0.5f)) * -parity(n); }
+
+// sin(2 pi t), t is in turns
+template <typename T> FORCEINLINE T sinTurns(const T& t) {
+    const T f = t - floor(t + 0.5f); // [-0.5, 0.5]
+    const T g = select(f > 0.25f, 0.5f - f, select(f < -0.25f, -0.5f - f, f)); // sin(pi - a) = sin(a)
+    return sinReduced(g * (2.f * pi)); }
+
+// GPUs take sin/cos of x / 2pi in turns, rounding of that multiplication is the error that grows with |x|
+// and makes fract(43758.5453 * sin(x)) hashes differ from libm ones
+template <typename T> FORCEINLINE T gpuSin(const T& x) { return sinTurns(x * (0.5f / pi)); }
+template <typename T> FORCEINLINE T gpuCos(const T& x) { return sinTurns(x * (0.5f / pi) + 0.25f); }
+
+// e^r for |r| <= ln(2) / 2
+template <typename T> FORCEINLINE T expReduced(const T& r) {
+    const T p = ((((1.98756915e-4f * r + 1.39819995e-3f) * r + 8.33345191e-3f) * r + 4.16657959e-2f) * r + 1.66666655e-1f) * r + 5.00000012e-1f;
+    return p * (r * r) + r + 1.f; }
+
+// p * 2^n in two steps, so that the result can be denormal or close to FLT_MAX
+template <typename T> FORCEINLINE T scalePow2(const T& p, const T& n) {
+    const T n0 = floor(n * 0.5f); return p * pow2i(n0) * pow2i(n - n0); }
+
+template <typename T> FORCEINLINE T exp(const T& x) {
+    const T n = floor(x * 1.44269504f + 0.5f);
+    const T r = (x - n * 0.693359375f) + n * 2.12194440e-4f; // x - n * ln(2)
+    const T e = scalePow2(expReduced(r), n);
+    return select(x > 88.7228394f, T(inf), select(x < -103.972084f, T(0.f), e)); }
+
+template <typename T> FORCEINLINE T exp2(const T& x) {
+    const T n = floor(x + 0.5f);
+    const T e = scalePow2(expReduced((x - n) * 0.693147181f), n);
+    return select(x >= 128.f, T(inf), select(x < -150.f, T(0.f), e)); }
+
+// log(m) for x = m * 2^e, m in [sqrt(0.5), sqrt(2)), e is returned too
+template <typename T> FORCEINLINE T logReduced(const T& x, T& e) {
+    T m = mantissa(x);
+    e = exponent(x);
+    const auto big = m > 1.41421356f;
+    m = select(big, m * 0.5f, m);
+    e = select(big, e + 1.f, e);
+    const T f = m - 1.f, z = f * f;
+    const T p = ((((((((7.0376836292e-2f * f - 1.1514610310e-1f) * f + 1.1676998740e-1f) * f - 1.2420140846e-1f) * f
+        + 1.4249322787e-1f) * f - 1.6668057665e-1f) * f + 2.0000714765e-1f) * f - 2.4999993993e-1f) * f + 3.3333331174e-1f);
+    return f + (f * z * p - 0.5f * z); }
+
+// 0 and denormals give -inf, negatives NaN
+template <typename T> FORCEINLINE T logSpecial(const T& x, const T& r) {
+    const T low = select(x < 0.f || x != x, T(nan), T(-inf));
+    return select(x == inf, T(inf), select(x >= 1.17549435e-38f, r, low)); }
+
+template <typename T> FORCEINLINE T log(const T& x) {
+    T e;
+    const T m = logReduced(x, e);
+    return logSpecial(x, (m + e * -2.12194440e-4f) + e * 0.693359375f); } // + e * ln(2)
+
+template <typename T> FORCEINLINE T log2(const T& x) {
+    T e;
+    const T m = logReduced(x, e);
+    return logSpecial(x, m * 1.44269504f + e); }
+
+// x < 0 gives NaN, it's undefined in GLSL
+template <typename T> FORCEINLINE T pow(const T& x, const T& y) { return ShaderMath::exp2(y * ShaderMath::log2(x)); }
+
+template <typename T> FORCEINLINE T atan(const T& x) {
+    // atan(|x|) = offset + atan(t), |t| <= tan(pi/8)
+    const T ax = abs(x);
+    const auto big = ax > 2.41421356f, mid = ax > 0.414213562f;
+    const T offset = select(big, T(pi * 0.5f), select(mid, T(pi * 0.25f), T(0.f)));
+    const T t = select(big, T(-1.f), select(mid, ax - 1.f, ax)) / select(big, ax, select(mid, ax + 1.f, T(1.f)));
+    const T z = t * t;
+    const T r = offset + (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * t + t;
+    return select(x < 0.f, -r, r); }
+
+// atan(y / x) in [-pi, pi]
+template <typename T> FORCEINLINE T atan2(const T& y, const T& x) {
+    const T r = ShaderMath::atan(y / x);
+    return select(x < 0.f, r + select(y < 0.f, T(-pi), T(pi)), r); }
+
+// With LIB_MATH_GPU denormal inputs and results are flushed to zero on this thread while the scope is alive
+// (x86 MXCSR FTZ and DAZ, other CPUs keep denormals). Utils::parallelFor passes it to its threads.
+// Does nothing in other modes.
+// GCC and Clang builtins instead of xmmintrin.h, it pulls stdlib.h abs() into the shader_lib module.
+class FloatEnvironmentScope {
+public:
+#if LIB_CURRENT_MATH == LIB_MATH_GPU && defined(__SSE__) && (defined(__GNUC__) || defined(__clang__))
+    FloatEnvironmentScope() : saved(__builtin_ia32_stmxcsr()) { __builtin_ia32_ldmxcsr(saved | 0x8040); }
+    ~FloatEnvironmentScope() { __builtin_ia32_ldmxcsr(saved); }
+
+private:
+    unsigned int saved;
+#elif LIB_CURRENT_MATH == LIB_MATH_GPU && defined(_MSC_VER) && defined(_M_X64)
+    FloatEnvironmentScope() : saved(_mm_getcsr()) { _mm_setcsr(saved | 0x8040); }
+    ~FloatEnvironmentScope() { _mm_setcsr(saved); }
+
+private:
+    unsigned int saved;
+#else
+    // user-provided, so scope variables don't warn as unused
+    FloatEnvironmentScope() {}
+    ~FloatEnvironmentScope() {}
+#endif
+};
+
+} // namespace ShaderMath
+
+// clang-format on
+
+#endif // SHADER_MATH_H
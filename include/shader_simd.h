@@ -0,0 +1,378 @@
+#ifndef SHADER_SIMD_H
+#define SHADER_SIMD_H
+
+#include "shader_lib.h"
+
+// Packets are N floats ("lanes") processed together. Vector3_base<FloatPacket<8>> is 8 vec3-s
+// in SoA layout (8 x-s, 8 y-s, 8 z-s), so shader code written for vec3 evaluates 8 points per call
+// when vec3 is replaced with vec3x8. Branches don't work on packets, use select(mask, a, b) instead.
+
+// Backends: SSE4.1 for 4 lanes, AVX for 8 lanes, AVX-512F for 16 lanes, if they are enabled
+// in the compiler (-msse4.1, -mavx2, -mavx512f, -march=native or /arch:AVX2),
+// plain arrays otherwise (compiler usually vectorizes those loops too).
+
+#if defined(__SSE4_1__) || defined(__AVX__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// clang-format off
+
+namespace simd {
+
+template <int N>
+struct PortableBackend {
+    struct Reg { float v[N]; };
+    struct Mask { bool m[N]; };
+
+#define SHADER_SIMD_PORTABLE_UNARY(name, expr) \
+    static FORCEINLINE Reg name(const Reg& a) { Reg r; for (int i = 0; i < N; ++i) { const float x = a.v[i]; r.v[i] = expr; } return r; }
+#define SHADER_SIMD_PORTABLE_BINARY(name, expr) \
+    static FORCEINLINE Reg name(const Reg& a, const Reg& b) { Reg r; for (int i = 0; i < N; ++i) { const float x = a.v[i], y = b.v[i]; r.v[i] = expr; } return r; }
+#define SHADER_SIMD_PORTABLE_COMPARE(name, op) \
+    static FORCEINLINE Mask name(const Reg& a, const Reg& b) { Mask r; for (int i = 0; i < N; ++i) r.m[i] = a.v[i] op b.v[i]; return r; }
+
+    static FORCEINLINE Reg set1(float f) { Reg r; for (int i = 0; i < N; ++i) r.v[i] = f; return r; }
+    static FORCEINLINE Reg load(const float* p) { Reg r; for (int i = 0; i < N; ++i) r.v[i] = p[i]; return r; }
+    static FORCEINLINE void store(float* p, const Reg& a) { for (int i = 0; i < N; ++i) p[i] = a.v[i]; }
+
+    SHADER_SIMD_PORTABLE_UNARY(neg, -x)
+    SHADER_SIMD_PORTABLE_UNARY(abs, std::abs(x))
+    SHADER_SIMD_PORTABLE_UNARY(floor, floorf(x))
+    SHADER_SIMD_PORTABLE_UNARY(sqrt, std::sqrt(x))
+    SHADER_SIMD_PORTABLE_UNARY(rsqrt, 1.f / std::sqrt(x))
+    SHADER_SIMD_PORTABLE_UNARY(pow2i, ShaderMath::pow2i(x))
+    SHADER_SIMD_PORTABLE_UNARY(exponent, ShaderMath::exponent(x))
+    SHADER_SIMD_PORTABLE_UNARY(mantissa, ShaderMath::mantissa(x))
+    SHADER_SIMD_PORTABLE_BINARY(add, x + y)
+    SHADER_SIMD_PORTABLE_BINARY(sub, x - y)
+    SHADER_SIMD_PORTABLE_BINARY(mul, x * y)
+    SHADER_SIMD_PORTABLE_BINARY(div, x / y)
+    SHADER_SIMD_PORTABLE_BINARY(min, y < x ? y : x)
+    SHADER_SIMD_PORTABLE_BINARY(max, x < y ? y : x)
+    SHADER_SIMD_PORTABLE_COMPARE(lt, <)
+    SHADER_SIMD_PORTABLE_COMPARE(le, <=)
+    SHADER_SIMD_PORTABLE_COMPARE(gt, >)
+    SHADER_SIMD_PORTABLE_COMPARE(ge, >=)
+    SHADER_SIMD_PORTABLE_COMPARE(eq, ==)
+    SHADER_SIMD_PORTABLE_COMPARE(ne, !=)
+
+#undef SHADER_SIMD_PORTABLE_UNARY
+#undef SHADER_SIMD_PORTABLE_BINARY
+#undef SHADER_SIMD_PORTABLE_COMPARE
+
+    static FORCEINLINE Reg select(const Mask& m, const Reg& a, const Reg& b) { Reg r; for (int i = 0; i < N; ++i) r.v[i] = m.m[i] ? a.v[i] : b.v[i]; return r; }
+    static FORCEINLINE Mask maskAnd(const Mask& a, const Mask& b) { Mask r; for (int i = 0; i < N; ++i) r.m[i] = a.m[i] && b.m[i]; return r; }
+    static FORCEINLINE Mask maskOr(const Mask& a, const Mask& b) { Mask r; for (int i = 0; i < N; ++i) r.m[i] = a.m[i] || b.m[i]; return r; }
+    static FORCEINLINE Mask maskNot(const Mask& a) { Mask r; for (int i = 0; i < N; ++i) r.m[i] = !a.m[i]; return r; }
+    static FORCEINLINE uint32_t maskBits(const Mask& a) { uint32_t bits = 0; for (int i = 0; i < N; ++i) bits |= uint32_t(a.m[i]) << i; return bits; }
+};
+
+#if defined(__SSE4_1__)
+struct SSEBackend {
+    typedef __m128 Reg;
+    typedef __m128 Mask;
+
+    static FORCEINLINE Reg set1(float f) { return _mm_set1_ps(f); }
+    static FORCEINLINE Reg load(const float* p) { return _mm_loadu_ps(p); }
+    static FORCEINLINE void store(float* p, Reg a) { _mm_storeu_ps(p, a); }
+
+    static FORCEINLINE Reg neg(Reg a) { return _mm_xor_ps(a, _mm_set1_ps(-0.f)); }
+    static FORCEINLINE Reg abs(Reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+    static FORCEINLINE Reg floor(Reg a) { return _mm_floor_ps(a); }
+    static FORCEINLINE Reg sqrt(Reg a) { return _mm_sqrt_ps(a); }
+    static FORCEINLINE Reg rsqrt(Reg a) { return _mm_rsqrt_ps(a); } // 12 bits
+    // float exponent bits for shader_math.h kernels
+    static FORCEINLINE Reg pow2i(Reg n) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23)); }
+    static FORCEINLINE Reg exponent(Reg a) {
+        return _mm_cvtepi32_ps(_mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(_mm_castps_si128(a), 23), _mm_set1_epi32(0xff)), _mm_set1_epi32(127))); }
+    static FORCEINLINE Reg mantissa(Reg a) { return _mm_or_ps(_mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x007fffff))), _mm_set1_ps(1.f)); }
+    static FORCEINLINE Reg add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+    static FORCEINLINE Reg sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+    static FORCEINLINE Reg mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+    static FORCEINLINE Reg div(Reg a, Reg b) { return _mm_div_ps(a, b); }
+    static FORCEINLINE Reg min(Reg a, Reg b) { return _mm_min_ps(b, a); } // returns a if b is NaN, same as portable one
+    static FORCEINLINE Reg max(Reg a, Reg b) { return _mm_max_ps(b, a); }
+    static FORCEINLINE Mask lt(Reg a, Reg b) { return _mm_cmplt_ps(a, b); }
+    static FORCEINLINE Mask le(Reg a, Reg b) { return _mm_cmple_ps(a, b); }
+    static FORCEINLINE Mask gt(Reg a, Reg b) { return _mm_cmpgt_ps(a, b); }
+    static FORCEINLINE Mask ge(Reg a, Reg b) { return _mm_cmpge_ps(a, b); }
+    static FORCEINLINE Mask eq(Reg a, Reg b) { return _mm_cmpeq_ps(a, b); }
+    static FORCEINLINE Mask ne(Reg a, Reg b) { return _mm_cmpneq_ps(a, b); }
+
+    static FORCEINLINE Reg select(Mask m, Reg a, Reg b) { return _mm_blendv_ps(b, a, m); }
+    static FORCEINLINE Mask maskAnd(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    static FORCEINLINE Mask maskOr(Mask a, Mask b) { return _mm_or_ps(a, b); }
+    static FORCEINLINE Mask maskNot(Mask a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+    static FORCEINLINE uint32_t maskBits(Mask a) { return _mm_movemask_ps(a); }
+};
+#endif
+
+#if defined(__AVX__)
+struct AVXBackend {
+    typedef __m256 Reg;
+    typedef __m256 Mask;
+
+    static FORCEINLINE Reg set1(float f) { return _mm256_set1_ps(f); }
+    static FORCEINLINE Reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static FORCEINLINE void store(float* p, Reg a) { _mm256_storeu_ps(p, a); }
+
+    static FORCEINLINE Reg neg(Reg a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.f)); }
+    static FORCEINLINE Reg abs(Reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+    static FORCEINLINE Reg floor(Reg a) { return _mm256_floor_ps(a); }
+    static FORCEINLINE Reg sqrt(Reg a) { return _mm256_sqrt_ps(a); }
+    static FORCEINLINE Reg rsqrt(Reg a) { return _mm256_rsqrt_ps(a); }
+#if defined(__AVX2__)
+    static FORCEINLINE Reg pow2i(Reg n) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23)); }
+    static FORCEINLINE Reg exponent(Reg a) {
+        return _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(_mm256_castps_si256(a), 23), _mm256_set1_epi32(0xff)), _mm256_set1_epi32(127))); }
+#else // no 256 bit integer instructions in AVX1, halves go through SSE
+    static FORCEINLINE Reg pow2i(Reg n) { return _mm256_set_m128(SSEBackend::pow2i(_mm256_extractf128_ps(n, 1)), SSEBackend::pow2i(_mm256_castps256_ps128(n))); }
+    static FORCEINLINE Reg exponent(Reg a) { return _mm256_set_m128(SSEBackend::exponent(_mm256_extractf128_ps(a, 1)), SSEBackend::exponent(_mm256_castps256_ps128(a))); }
+#endif
+    static FORCEINLINE Reg mantissa(Reg a) { return _mm256_or_ps(_mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff))), _mm256_set1_ps(1.f)); }
+    static FORCEINLINE Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+    static FORCEINLINE Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+    static FORCEINLINE Reg mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+    static FORCEINLINE Reg div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+    static FORCEINLINE Reg min(Reg a, Reg b) { return _mm256_min_ps(b, a); }
+    static FORCEINLINE Reg max(Reg a, Reg b) { return _mm256_max_ps(b, a); }
+    static FORCEINLINE Mask lt(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static FORCEINLINE Mask le(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static FORCEINLINE Mask gt(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static FORCEINLINE Mask ge(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static FORCEINLINE Mask eq(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static FORCEINLINE Mask ne(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+
+    static FORCEINLINE Reg select(Mask m, Reg a, Reg b) { return _mm256_blendv_ps(b, a, m); }
+    static FORCEINLINE Mask maskAnd(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+    static FORCEINLINE Mask maskOr(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+    static FORCEINLINE Mask maskNot(Mask a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+    static FORCEINLINE uint32_t maskBits(Mask a) { return _mm256_movemask_ps(a); }
+};
+#endif
+
+#if defined(__AVX512F__)
+struct AVX512Backend {
+    typedef __m512 Reg;
+    typedef __mmask16 Mask;
+
+    static FORCEINLINE Reg set1(float f) { return _mm512_set1_ps(f); }
+    static FORCEINLINE Reg load(const float* p) { return _mm512_loadu_ps(p); }
+    static FORCEINLINE void store(float* p, Reg a) { _mm512_storeu_ps(p, a); }
+
+    static FORCEINLINE Reg neg(Reg a) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x80000000))); }
+    static FORCEINLINE Reg abs(Reg a) { return _mm512_abs_ps(a); }
+    static FORCEINLINE Reg floor(Reg a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    static FORCEINLINE Reg sqrt(Reg a) { return _mm512_sqrt_ps(a); }
+    static FORCEINLINE Reg rsqrt(Reg a) { return _mm512_rsqrt14_ps(a); } // 14 bits
+    // not getexp/getmant, they handle 0 and denormals differently from other backends
+    static FORCEINLINE Reg pow2i(Reg n) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvttps_epi32(n), _mm512_set1_epi32(127)), 23)); }
+    static FORCEINLINE Reg exponent(Reg a) {
+        return _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_and_si512(_mm512_srli_epi32(_mm512_castps_si512(a), 23), _mm512_set1_epi32(0xff)), _mm512_set1_epi32(127))); }
+    static FORCEINLINE Reg mantissa(Reg a) {
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f800000))); }
+    static FORCEINLINE Reg add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+    static FORCEINLINE Reg sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+    static FORCEINLINE Reg mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+    static FORCEINLINE Reg div(Reg a, Reg b) { return _mm512_div_ps(a, b); }
+    static FORCEINLINE Reg min(Reg a, Reg b) { return _mm512_min_ps(b, a); }
+    static FORCEINLINE Reg max(Reg a, Reg b) { return _mm512_max_ps(b, a); }
+    static FORCEINLINE Mask lt(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static FORCEINLINE Mask le(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    static FORCEINLINE Mask gt(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static FORCEINLINE Mask ge(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+    static FORCEINLINE Mask eq(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static FORCEINLINE Mask ne(Reg a, Reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_NEQ_UQ); }
+
+    static FORCEINLINE Reg select(Mask m, Reg a, Reg b) { return _mm512_mask_blend_ps(m, b, a); }
+    static FORCEINLINE Mask maskAnd(Mask a, Mask b) { return a & b; }
+    static FORCEINLINE Mask maskOr(Mask a, Mask b) { return a | b; }
+    static FORCEINLINE Mask maskNot(Mask a) { return Mask(~a); }
+    static FORCEINLINE uint32_t maskBits(Mask a) { return a; }
+};
+#endif
+
+template <int N> struct BackendFor { typedef PortableBackend<N> type; };
+#if defined(__SSE4_1__)
+template <> struct BackendFor<4> { typedef SSEBackend type; };
+#endif
+#if defined(__AVX__)
+template <> struct BackendFor<8> { typedef AVXBackend type; };
+#endif
+#if defined(__AVX512F__)
+template <> struct BackendFor<16> { typedef AVX512Backend type; };
+#endif
+
+} // namespace simd
+
+// Result of packet comparison, one bool per lane
+template <int N>
+struct MaskPacket {
+    typedef typename simd::BackendFor<N>::type B;
+
+    MaskPacket() = default;
+    FORCEINLINE explicit MaskPacket(typename B::Mask m) : m(m) {}
+
+    FORCEINLINE uint32_t bits() const { return B::maskBits(m); } // lane i is bit i
+    FORCEINLINE bool any() const { return bits() != 0; }
+    FORCEINLINE bool all() const { return bits() == (uint32_t(-1) >> (32 - N)); }
+    FORCEINLINE bool operator[](int i) const { assert(i < N); return (bits() >> i) & 1; }
+
+    friend FORCEINLINE MaskPacket operator&&(const MaskPacket& a, const MaskPacket& b) { return MaskPacket(B::maskAnd(a.m, b.m)); }
+    friend FORCEINLINE MaskPacket operator||(const MaskPacket& a, const MaskPacket& b) { return MaskPacket(B::maskOr(a.m, b.m)); }
+    friend FORCEINLINE MaskPacket operator!(const MaskPacket& a) { return MaskPacket(B::maskNot(a.m)); }
+
+    typename B::Mask m;
+};
+
+template <int N>
+struct FloatPacket {
+    typedef typename simd::BackendFor<N>::type B;
+    typedef typename B::Reg Reg;
+    static constexpr int size = N;
+
+    FloatPacket() = default;
+    FORCEINLINE FloatPacket(float f) : r(B::set1(f)) {}
+    FORCEINLINE explicit FloatPacket(Reg r) : r(r) {}
+
+    // p doesn't have to be aligned
+    static FORCEINLINE FloatPacket load(const float* p) { return FloatPacket(B::load(p)); }
+    FORCEINLINE void store(float* p) const { B::store(p, r); }
+
+    FORCEINLINE float operator[](int i) const { assert(i < N); float lanes[N]; store(lanes); return lanes[i]; }
+
+    friend FORCEINLINE FloatPacket operator-(const FloatPacket& a) { return FloatPacket(B::neg(a.r)); }
+
+#define SHADER_SIMD_DECLARE_OPERATOR_FloatPacket(op, impl)                                                             \
+    friend FORCEINLINE FloatPacket operator op(const FloatPacket& a, const FloatPacket& b) { return FloatPacket(B::impl(a.r, b.r)); } \
+    FORCEINLINE FloatPacket& operator op##=(const FloatPacket& rhs) { r = B::impl(r, rhs.r); return *this; }
+
+SHADER_SIMD_DECLARE_OPERATOR_FloatPacket(+, add)
+SHADER_SIMD_DECLARE_OPERATOR_FloatPacket(-, sub)
+SHADER_SIMD_DECLARE_OPERATOR_FloatPacket(*, mul)
+SHADER_SIMD_DECLARE_OPERATOR_FloatPacket(/, div)
+#undef SHADER_SIMD_DECLARE_OPERATOR_FloatPacket
+
+#define SHADER_SIMD_DECLARE_COMPARE_FloatPacket(op, impl) \
+    friend FORCEINLINE MaskPacket<N> operator op(const FloatPacket& a, const FloatPacket& b) { return MaskPacket<N>(B::impl(a.r, b.r)); }
+
+SHADER_SIMD_DECLARE_COMPARE_FloatPacket(<, lt)
+SHADER_SIMD_DECLARE_COMPARE_FloatPacket(<=, le)
+SHADER_SIMD_DECLARE_COMPARE_FloatPacket(>, gt)
+SHADER_SIMD_DECLARE_COMPARE_FloatPacket(>=, ge)
+SHADER_SIMD_DECLARE_COMPARE_FloatPacket(==, eq)
+SHADER_SIMD_DECLARE_COMPARE_FloatPacket(!=, ne)
+#undef SHADER_SIMD_DECLARE_COMPARE_FloatPacket
+
+    // mask ? a : b, per lane
+    friend FORCEINLINE FloatPacket select(const MaskPacket<N>& mask, const FloatPacket& a, const FloatPacket& b) { return FloatPacket(B::select(mask.m, a.r, b.r)); }
+
+    // lane-wise versions of scalar functions from shader_lib.h
+    friend FORCEINLINE FloatPacket min(const FloatPacket& a, const FloatPacket& b) { return FloatPacket(B::min(a.r, b.r)); }
+    friend FORCEINLINE FloatPacket max(const FloatPacket& a, const FloatPacket& b) { return FloatPacket(B::max(a.r, b.r)); }
+    friend FORCEINLINE FloatPacket clamp(const FloatPacket& x, const FloatPacket& inMin, const FloatPacket& inMax) { return min(inMax, max(x, inMin)); }
+    friend FORCEINLINE FloatPacket abs(const FloatPacket& a) { return FloatPacket(B::abs(a.r)); }
+    friend FORCEINLINE FloatPacket floor(const FloatPacket& a) { return FloatPacket(B::floor(a.r)); }
+#if LIB_CURRENT_MATH == LIB_MATH_GPU
+    friend FORCEINLINE FloatPacket FRAC(const FloatPacket& a) { return min(a - floor(a), FloatPacket(0.99999994f)); }
+#else
+    friend FORCEINLINE FloatPacket FRAC(const FloatPacket& a) { return a - floor(a); }
+#endif
+    friend FORCEINLINE FloatPacket sqrt(const FloatPacket& a) { return FloatPacket(B::sqrt(a.r)); }
+    friend FORCEINLINE FloatPacket sign(const FloatPacket& a) { return select(a > 0.f, FloatPacket(1.f), select(a < 0.f, FloatPacket(-1.f), FloatPacket(0.f))); }
+    friend FORCEINLINE FloatPacket lerp(const FloatPacket& a, const FloatPacket& b, const FloatPacket& x) { return a + (b - a) * x; }
+    friend FORCEINLINE FloatPacket smoothstep(const FloatPacket& edge0, const FloatPacket& edge1, FloatPacket t) {
+        t = clamp(DIV_IMPL(t - edge0, edge1 - edge0), 0.f, 1.f); return t * t * (3.f - 2.f * t); }
+#if LIB_CURRENT_LANGUAGE == LIB_HLSL
+    friend FORCEINLINE FloatPacket saturate(const FloatPacket& a) { return clamp(a, 0.f, 1.f); }
+#endif
+
+    friend FORCEINLINE FloatPacket mod(const FloatPacket& x, const FloatPacket& y) { return x - y * floor(DIV_IMPL(x, y)); }
+    friend FORCEINLINE FloatPacket step(const FloatPacket& edge, const FloatPacket& x) { return select(x < edge, FloatPacket(0.f), FloatPacket(1.f)); }
+
+    // primitives of shader_math.h kernels
+    friend FORCEINLINE FloatPacket pow2i(const FloatPacket& n) { return FloatPacket(B::pow2i(n.r)); }
+    friend FORCEINLINE FloatPacket exponent(const FloatPacket& a) { return FloatPacket(B::exponent(a.r)); }
+    friend FORCEINLINE FloatPacket mantissa(const FloatPacket& a) { return FloatPacket(B::mantissa(a.r)); }
+
+#if LIB_CURRENT_MATH != LIB_MATH_STD
+    // shader_math.h kernels, same as for floats
+    friend FORCEINLINE FloatPacket sin(const FloatPacket& a) { return SIN_IMPL(a); }
+    friend FORCEINLINE FloatPacket cos(const FloatPacket& a) { return COS_IMPL(a); }
+    friend FORCEINLINE FloatPacket atan(const FloatPacket& a) { return ATAN_IMPL(a); }
+    friend FORCEINLINE FloatPacket atan(const FloatPacket& y, const FloatPacket& x) { return ATAN2_IMPL(y, x); }
+    friend FORCEINLINE FloatPacket exp(const FloatPacket& a) { return EXP_IMPL(a); }
+    friend FORCEINLINE FloatPacket exp2(const FloatPacket& a) { return EXP2_IMPL(a); }
+    friend FORCEINLINE FloatPacket log(const FloatPacket& a) { return LOG_IMPL(a); }
+    friend FORCEINLINE FloatPacket log2(const FloatPacket& a) { return LOG2_IMPL(a); }
+    friend FORCEINLINE FloatPacket pow(const FloatPacket& x, const FloatPacket& y) { return POW_IMPL(x, y); }
+#endif
+#if LIB_CURRENT_MATH == LIB_MATH_FAST
+    // estimate and a Newton step, 0 and inf keep the estimate (inf and 0).
+    // Estimates differ between instruction sets, LIB_MATH_GPU divides to get the same bits everywhere
+    friend FORCEINLINE FloatPacket INVERSESQRT(const FloatPacket& a) {
+        const FloatPacket r(B::rsqrt(a.r)); return select(a > 0.f && a < ShaderMath::inf, r * (1.5f - 0.5f * a * r * r), r); }
+#elif LIB_CURRENT_MATH == LIB_MATH_GPU
+    friend FORCEINLINE FloatPacket INVERSESQRT(const FloatPacket& a) { return 1.f / sqrt(a); }
+#else
+    // no vector instructions in libm, lanes go through *_IMPL one by one
+#define SHADER_SIMD_LANEWISE_FloatPacket(name, impl) \
+    friend FORCEINLINE FloatPacket name(const FloatPacket& a) { float lanes[N]; a.store(lanes); for (float& f : lanes) f = impl(f); return load(lanes); }
+#define SHADER_SIMD_LANEWISE2_FloatPacket(name, impl)                                                        \
+    friend FORCEINLINE FloatPacket name(const FloatPacket& a, const FloatPacket& b) {                       \
+        float lanesA[N], lanesB[N]; a.store(lanesA); b.store(lanesB);                                       \
+        for (int i = 0; i < N; ++i) { lanesA[i] = impl(lanesA[i], lanesB[i]); }                            \
+        return load(lanesA); }
+
+SHADER_SIMD_LANEWISE_FloatPacket(sin, SIN_IMPL)
+SHADER_SIMD_LANEWISE_FloatPacket(cos, COS_IMPL)
+SHADER_SIMD_LANEWISE_FloatPacket(atan, ATAN_IMPL)
+SHADER_SIMD_LANEWISE2_FloatPacket(atan, ATAN2_IMPL)
+SHADER_SIMD_LANEWISE_FloatPacket(exp, EXP_IMPL)
+SHADER_SIMD_LANEWISE_FloatPacket(exp2, EXP2_IMPL)
+SHADER_SIMD_LANEWISE_FloatPacket(log, LOG_IMPL)
+SHADER_SIMD_LANEWISE_FloatPacket(log2, LOG2_IMPL)
+SHADER_SIMD_LANEWISE2_FloatPacket(pow, POW_IMPL)
+#undef SHADER_SIMD_LANEWISE_FloatPacket
+#undef SHADER_SIMD_LANEWISE2_FloatPacket
+
+    friend FORCEINLINE FloatPacket INVERSESQRT(const FloatPacket& a) { return 1.f / sqrt(a); }
+#endif
+
+    Reg r;
+};
+
+// VECTOR FUNCTIONS
+// shader_lib.h ones, calling the packet friends above
+
+SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(FloatPacket<4>)
+SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(FloatPacket<8>)
+SHADER_LIB_DECLARE_VECTOR_FUNCTIONS(FloatPacket<16>)
+
+// mask ? a : b, per lane
+template <int N> FORCEINLINE Vector2_base<FloatPacket<N>> select(const MaskPacket<N>& m, const Vector2_base<FloatPacket<N>>& a, const Vector2_base<FloatPacket<N>>& b) {
+    return Vector2_base<FloatPacket<N>>(select(m, a.x, b.x), select(m, a.y, b.y)); }
+template <int N> FORCEINLINE Vector3_base<FloatPacket<N>> select(const MaskPacket<N>& m, const Vector3_base<FloatPacket<N>>& a, const Vector3_base<FloatPacket<N>>& b) {
+    return Vector3_base<FloatPacket<N>>(select(m, a.x, b.x), select(m, a.y, b.y), select(m, a.z, b.z)); }
+template <int N> FORCEINLINE Vector4_base<FloatPacket<N>> select(const MaskPacket<N>& m, const Vector4_base<FloatPacket<N>>& a, const Vector4_base<FloatPacket<N>>& b) {
+    return Vector4_base<FloatPacket<N>>(select(m, a.x, b.x), select(m, a.y, b.y), select(m, a.z, b.z), select(m, a.w, b.w)); }
+
+typedef FloatPacket<4> floatx4;
+typedef FloatPacket<8> floatx8;
+typedef FloatPacket<16> floatx16;
+
+#if LIB_CURRENT_LANGUAGE == LIB_GLSL
+    typedef Vector2_base<floatx4> vec2x4;
+    typedef Vector3_base<floatx4> vec3x4;
+    typedef Vector4_base<floatx4> vec4x4;
+    typedef Vector2_base<floatx8> vec2x8;
+    typedef Vector3_base<floatx8> vec3x8;
+    typedef Vector4_base<floatx8> vec4x8;
+    typedef Vector2_base<floatx16> vec2x16;
+    typedef Vector3_base<floatx16> vec3x16;
+    typedef Vector4_base<floatx16> vec4x16;
+#endif // HLSL float3x4 etc. are matrices, use Vector3_base<floatx4> there
+
+// clang-format on
+
+#endif // SHADER_SIMD_H